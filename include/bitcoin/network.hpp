@@ -16,15 +16,28 @@
 
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/acceptor.hpp>
+#include <bitcoin/network/block_decoder.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connection_slab.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/header_hasher.hpp>
 #include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/memory_governor.hpp>
+#include <bitcoin/network/message_pool.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
 #include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/payload_cache.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/snapshot_resubscriber.hpp>
+#include <bitcoin/network/thread_placement.hpp>
+#include <bitcoin/network/thread_scaler.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+#include <bitcoin/network/unique_function.hpp>
 #include <bitcoin/network/version.hpp>
+#include <bitcoin/network/wire_payload.hpp>
 #include <bitcoin/network/protocols/protocol.hpp>
 #include <bitcoin/network/protocols/protocol_address_31402.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
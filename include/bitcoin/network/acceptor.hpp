@@ -25,8 +25,13 @@
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connection_slab.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/memory_governor.hpp>
+#include <bitcoin/network/payload_cache.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -42,7 +47,10 @@ public:
     typedef std::function<void(const code&, channel::ptr)> accept_handler;
 
     /// Construct an instance.
-    acceptor(threadpool& pool, const settings& settings);
+    acceptor(threadpool& pool, timer_wheel& timers,
+        priority_dispatcher& dispatch, payload_cache& payloads,
+        connection_slab& slab, memory_governor& governor,
+        const settings& settings);
 
     /// Validate acceptor stopped.
     ~acceptor();
@@ -60,11 +68,17 @@ private:
     virtual bool stopped() const;
 
     void handle_accept(const boost_code& ec, socket::ptr socket,
+        const connection_slab::byte_allocator& allocator,
         accept_handler handler);
 
     // These are thread safe.
     std::atomic<bool> stopped_;
     threadpool& pool_;
+    timer_wheel& timers_;
+    priority_dispatcher& priority_dispatch_;
+    payload_cache& payloads_;
+    connection_slab& slab_;
+    memory_governor& governor_;
     const settings& settings_;
     mutable dispatcher dispatch_;
 
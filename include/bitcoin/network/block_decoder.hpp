@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BLOCK_DECODER_HPP
+#define LIBBITCOIN_NETWORK_BLOCK_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Decodes block, transaction and headers payloads, caching the transaction
+/// and header hashes computed from the wire bytes. The transactions of large
+/// blocks are parsed in parallel chunks. The calling thread parses chunks
+/// alongside pool threads, so decoding completes even if no pool thread is
+/// available.
+/// Thread safe.
+class BCT_API block_decoder
+  : noncopyable
+{
+public:
+    typedef std::vector<size_t> offsets;
+
+    /**
+     * Construct a decoder.
+     * @param[in]  pool     The threadpool to share transaction parsing with.
+     * @param[in]  minimum  The smallest payload to parse in parallel.
+     */
+    block_decoder(threadpool& pool, size_t minimum);
+
+    /// Decode a block payload, false if invalid or not fully consumed.
+    bool decode(uint32_t version, const data_chunk& payload,
+        message::block& out) const;
+
+    /// Decode a transaction payload, false if invalid or not fully consumed.
+    bool decode(uint32_t version, const data_chunk& payload,
+        message::transaction& out) const;
+
+    /// Decode a headers payload, false if invalid or not fully consumed.
+    /// Header hashes are computed in batches by the header hasher.
+    bool decode(uint32_t version, const data_chunk& payload,
+        message::headers& out) const;
+
+    /**
+     * Check the proof of work of block and headers payloads before decode.
+     * Each header hash is computed from its wire bytes and compared to the
+     * target of its own bits, transactions are neither hashed nor parsed.
+     * @param[in]  type     The payload message type identifier.
+     * @param[in]  payload  The message payload.
+     * @return              False if any header fails its own target.
+     */
+    static bool check_work(message::message_type type,
+        const data_chunk& payload);
+
+    /**
+     * Determine if a block or transaction payload carries witness data, in
+     * which case its encoding depends upon the receiving peer.
+     * @param[in]  type     The payload message type identifier.
+     * @param[in]  payload  The (valid) message payload.
+     * @return              True if any transaction is segregated.
+     */
+    static bool segregated(message::message_type type,
+        const data_chunk& payload);
+
+    /**
+     * Find transaction boundaries without parsing the transactions.
+     * @param[in]  payload  The block payload.
+     * @param[in]  offset   The offset of the first transaction.
+     * @param[in]  count    The number of transactions.
+     * @param[out] out_ends The end offset of each transaction.
+     * @return              False if the transactions overrun the payload.
+     */
+    static bool scan(const data_chunk& payload, size_t offset, size_t count,
+        offsets& out_ends);
+
+private:
+    bool decode_transactions(const data_chunk& payload, size_t offset,
+        const offsets& ends, chain::transaction::list& out) const;
+
+    threadpool& pool_;
+    const size_t minimum_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -26,10 +26,15 @@
 #include <utility>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/connection_slab.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/memory_governor.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/payload_cache.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -42,7 +47,10 @@ public:
     typedef std::shared_ptr<channel> ptr;
 
     /// Construct an instance.
-    channel(threadpool& pool, socket::ptr socket, const settings& settings);
+    channel(threadpool& pool, socket::ptr socket, timer_wheel& timers,
+        priority_dispatcher& dispatch, payload_cache& payloads,
+        const connection_slab::byte_allocator& allocator,
+        memory_governor& governor, const settings& settings);
 
     void start(result_handler handler) override;
 
@@ -68,14 +76,19 @@ private:
     void start_expiration();
     void handle_expiration(const code& ec);
 
-    void start_inactivity();
+    void start_inactivity(const asio::duration& timeout);
     void handle_inactivity(const code& ec);
 
     std::atomic<bool> notify_;
     std::atomic<uint64_t> nonce_;
     bc::atomic<version_const_ptr> peer_version_;
-    deadline::ptr expiration_;
-    deadline::ptr inactivity_;
+    timer_wheel& timers_;
+    const asio::duration inactivity_period_;
+
+    // Wheel ticks at last receipt, written on each message (relaxed).
+    std::atomic<uint64_t> last_activity_;
+    timer_wheel::timer expiration_;
+    timer_wheel::timer inactivity_;
 };
 
 } // namespace network
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_CONNECTION_SLAB_HPP
+#define LIBBITCOIN_NETWORK_CONNECTION_SLAB_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A pool of fixed-size arenas, one per connection, sized for the connection
+/// limit. The socket and channel of a connection, with the proxy, timers and
+/// subscribers of the channel, are carved from its arena, so that a
+/// connection costs one slab entry instead of many heap allocations. An
+/// arena only grows, so it is not used for per-message allocations or for
+/// protocols, which the heap reclaims. An entry returns to the pool when the
+/// last object allocated from it, and the last allocator of it, is released.
+/// Allocation falls back to the heap when the pool or an entry is exhausted.
+/// Thread safe.
+class BCT_API connection_slab
+  : noncopyable
+{
+public:
+    /// The arena of one connection, objects are not freed individually.
+    class BCT_API entry
+      : noncopyable
+    {
+    public:
+        entry();
+
+        /// A block of the arena or nullptr if the arena is exhausted.
+        void* allocate(size_t size);
+
+        /// Release a block, false if the block is not of this arena.
+        bool deallocate(void* block);
+
+        /// Reference the entry, independent of allocations.
+        void hold();
+
+        /// Dereference the entry, returning it to the pool when unused.
+        void release();
+
+    private:
+        friend class connection_slab;
+
+        connection_slab* slab_;
+        uint8_t* begin_;
+        size_t size_;
+        std::atomic<size_t> used_;
+        std::atomic<size_t> references_;
+    };
+
+    /// A copyable allocator drawing from an entry, or the heap if none.
+    /// Each copy holds the entry, so an allocation that falls back to the
+    /// heap cannot leave its allocator referencing a returned entry.
+    template <typename Type>
+    class allocator
+    {
+    public:
+        typedef Type value_type;
+
+        allocator(entry* source=nullptr)
+          : source_(source)
+        {
+            if (source_ != nullptr)
+                source_->hold();
+        }
+
+        allocator(const allocator& other)
+          : allocator(other.source())
+        {
+        }
+
+        template <typename Other>
+        allocator(const allocator<Other>& other)
+          : allocator(other.source())
+        {
+        }
+
+        ~allocator()
+        {
+            if (source_ != nullptr)
+                source_->release();
+        }
+
+        allocator& operator=(const allocator& other)
+        {
+            // Held before release, in case this is the last reference.
+            if (other.source_ != nullptr)
+                other.source_->hold();
+
+            if (source_ != nullptr)
+                source_->release();
+
+            source_ = other.source_;
+            return *this;
+        }
+
+        Type* allocate(size_t count)
+        {
+            const auto size = count * sizeof(Type);
+            const auto block = source_ == nullptr ? nullptr :
+                source_->allocate(size);
+
+            return static_cast<Type*>(block != nullptr ? block :
+                ::operator new(size));
+        }
+
+        void deallocate(Type* block, size_t)
+        {
+            if (source_ == nullptr || !source_->deallocate(block))
+                ::operator delete(block);
+        }
+
+        entry* source() const
+        {
+            return source_;
+        }
+
+        template <typename Other>
+        bool operator==(const allocator<Other>& other) const
+        {
+            return source_ == other.source();
+        }
+
+        template <typename Other>
+        bool operator!=(const allocator<Other>& other) const
+        {
+            return source_ != other.source();
+        }
+
+    private:
+        entry* source_;
+    };
+
+    typedef allocator<uint8_t> byte_allocator;
+
+    /// Takes an entry for the first objects of a connection, which are then
+    /// held by the allocators and objects of the connection.
+    class BCT_API lease
+      : noncopyable
+    {
+    public:
+        /// Take an entry from the slab, none if the slab is exhausted.
+        lease(connection_slab& slab);
+
+        /// Release the entry, it remains in use by its allocations.
+        ~lease();
+
+        /// An allocator for the leased entry.
+        byte_allocator get_allocator() const;
+
+    private:
+        entry* const entry_;
+    };
+
+    /// Construct a slab of the given entry count and size, zero disables.
+    connection_slab(size_t entries, size_t entry_size);
+
+    /// True if the slab has entries.
+    bool enabled() const;
+
+    /// The number of entries not in use.
+    size_t available() const;
+
+private:
+    entry* acquire();
+    void release(entry* instance);
+
+    std::unique_ptr<uint8_t[]> memory_;
+    std::vector<entry> entries_;
+
+    // This is protected by mutex.
+    std::vector<entry*> free_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_HEADER_HASHER_HPP
+#define LIBBITCOIN_NETWORK_HEADER_HASHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Double SHA-256 of 80 byte block headers in batches, using the widest
+/// kernel supported by the processor (selected at runtime), thread safe.
+class BCT_API header_hasher
+{
+public:
+    enum class kernel
+    {
+        /// Portable, one header at a time.
+        scalar,
+
+        /// SHA extensions, one header at a time.
+        sha_ni,
+
+        /// Eight headers at a time.
+        avx2,
+
+        /// Sixteen headers at a time.
+        avx512
+    };
+
+    static const size_t header_size = 80;
+
+    /// The fastest kernel supported by this processor.
+    static kernel selected();
+
+    /// True if the kernel is supported by this processor.
+    static bool supported(kernel use);
+
+    /**
+     * Hash a sequence of headers with the selected kernel.
+     * @param[in]  headers  The first of the serialized headers.
+     * @param[in]  stride   The distance in bytes between headers (>= 80).
+     * @param[in]  count    The number of headers.
+     * @param[out] out      The count header hashes.
+     */
+    static void hash(const uint8_t* headers, size_t stride, size_t count,
+        hash_digest* out);
+
+    /// Hash a sequence of headers with the specified (supported) kernel.
+    static void hash(kernel use, const uint8_t* headers, size_t stride,
+        size_t count, hash_digest* out);
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
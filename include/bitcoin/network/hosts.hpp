@@ -54,6 +54,10 @@ public:
     virtual code stop();
 
     virtual size_t count() const;
+
+    /// The memory held by the address pool, fixed at its capacity.
+    virtual size_t memory_usage() const;
+
     virtual code fetch(address& out) const;
     virtual code fetch(address::list& out) const;
     virtual code remove(const address& host);
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_MEMORY_GOVERNOR_HPP
+#define LIBBITCOIN_NETWORK_MEMORY_GOVERNOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/unique_function.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Accounts the memory held by the network against a budget, and each
+/// category against an optional limit. Usage over the budget is met in
+/// stages: reads of connections holding backlog are paused, then inbound
+/// connections are refused, then the peers holding the most memory are
+/// disconnected. A category over its limit pauses reads only. A zero budget
+/// and limits disable the response but not the accounting. Thread safe.
+class BCT_API memory_governor
+  : noncopyable
+{
+public:
+    typedef unique_function<void()> resume_handler;
+    typedef std::function<void()> evict_handler;
+
+    /// The subsystems that reserve memory.
+    enum class category : size_t
+    {
+        payload,
+        outbound,
+        relay,
+        hosts
+    };
+
+    static const size_t categories = 4;
+
+    /// A byte limit for each category, zero for none.
+    typedef std::array<size_t, categories> limits;
+
+    /// The staged response to usage over budget, in order of severity.
+    enum class pressure
+    {
+        none,
+        pause_reads,
+        refuse_inbound,
+        disconnect
+    };
+
+    /// The memory reserved by one connection, released on destruct.
+    class BCT_API account
+      : noncopyable
+    {
+    public:
+        typedef std::shared_ptr<account> ptr;
+
+        account(memory_governor& governor);
+        ~account();
+
+        void reserve(category type, size_t bytes);
+        void release(category type, size_t bytes);
+
+        /// The total memory held by the connection.
+        size_t usage() const;
+
+        /// The memory held by the connection in the category.
+        size_t usage(category type) const;
+
+        /// True if the connection holds relay or outbound backlog in a
+        /// category that is over its limit, or while over budget.
+        bool backlogged() const;
+
+    private:
+        memory_governor& governor_;
+        std::array<std::atomic<size_t>, categories> usage_;
+    };
+
+    /// The name of a category, for reporting.
+    static const char* name(category type);
+
+    /// Construct a governor with the budget and category limits in bytes.
+    memory_governor(size_t budget, const limits& category_limits=limits{});
+
+    /// Invoke the handler once as usage enters the disconnect stage, rearmed
+    /// as usage leaves it. The handler is invoked on the reserving thread.
+    void start(evict_handler handler);
+
+    /// Resume suspended readers and clear the eviction handler.
+    void stop();
+
+    bool enabled() const;
+    size_t budget() const;
+    size_t limit(category type) const;
+
+    void reserve(category type, size_t bytes);
+    void release(category type, size_t bytes);
+
+    size_t usage() const;
+    size_t usage(category type) const;
+    pressure level() const;
+
+    /// Reads pause while usage is over budget or a category over its limit.
+    bool paused() const;
+
+    /// True if usage is over budget or the category over its limit.
+    bool over(category type) const;
+
+    /// Invoke the handler once usage is within budget, now if it is.
+    /// The handler is released uninvoked if the governor is stopped.
+    void suspend(resume_handler&& handler);
+
+private:
+    bool over_budget() const;
+    void resume();
+
+    const size_t budget_;
+    const limits limits_;
+    const size_t refuse_;
+    const size_t disconnect_;
+
+    // These are thread safe.
+    std::array<std::atomic<size_t>, categories> usage_;
+    std::atomic<size_t> total_;
+    std::atomic<bool> evicting_;
+    std::atomic<bool> waiting_;
+
+    // These are protected by mutex_.
+    bool stopped_;
+    evict_handler evict_;
+    std::vector<resume_handler> suspended_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,345 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_MESSAGE_POOL_HPP
+#define LIBBITCOIN_NETWORK_MESSAGE_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A bounded list of recycled items owned by one thread. Only the owner
+/// takes items, but any thread may return one, so an item released on
+/// another thread goes back to the thread that took it. Returns from other
+/// threads are batched and taken by the owner once its own items run out.
+/// Items are released when the owner exits, and items returned after that
+/// are released by the caller.
+template <typename Item, class Release>
+class thread_freelist
+{
+public:
+    typedef std::shared_ptr<thread_freelist> ptr;
+    static const size_t capacity = 256;
+
+    ~thread_freelist()
+    {
+        clear(items_);
+        clear(returned_);
+    }
+
+    /// Take an item or nullptr if empty, on the owning thread.
+    Item pop()
+    {
+        if (items_.empty())
+        {
+            ///////////////////////////////////////////////////////////////////
+            // Critical Section
+            unique_lock lock(mutex_);
+
+            // The vectors swap capacity, so this does not allocate.
+            items_.swap(returned_);
+            ///////////////////////////////////////////////////////////////////
+        }
+
+        if (items_.empty())
+            return nullptr;
+
+        const auto item = items_.back();
+        items_.pop_back();
+        return item;
+    }
+
+    /// Return an item from any thread, false if full or the owner has
+    /// exited (the caller releases it).
+    bool push(Item item)
+    {
+        if (std::this_thread::get_id() == owner_)
+        {
+            if (closed_ || items_.size() >= capacity)
+                return false;
+
+            items_.push_back(item);
+            return true;
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(mutex_);
+
+        if (closed_ || returned_.size() >= capacity)
+            return false;
+
+        returned_.push_back(item);
+        return true;
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    /// The list of the calling thread, nullptr once it has been closed.
+    /// Items released by other thread local destructors during thread exit
+    /// are then released by the caller.
+    static ptr local()
+    {
+        // The flag is trivially destructible, so it outlives the list.
+        static thread_local bool destroyed = false;
+
+        if (destroyed)
+            return nullptr;
+
+        static thread_local owner list(destroyed);
+        return list.instance;
+    }
+
+private:
+    // Closes the list of a thread on its exit. The list itself lives on
+    // while items taken from it are outstanding.
+    struct owner
+    {
+        owner(bool& destroyed)
+          : destroyed(destroyed),
+            instance(new thread_freelist)
+        {
+        }
+
+        ~owner()
+        {
+            destroyed = true;
+            instance->close();
+        }
+
+        bool& destroyed;
+        const ptr instance;
+    };
+
+    thread_freelist()
+      : owner_(std::this_thread::get_id()),
+        closed_(false)
+    {
+        items_.reserve(capacity);
+        returned_.reserve(capacity);
+    }
+
+    static void clear(std::vector<Item>& items)
+    {
+        for (const auto item: items)
+            Release()(item);
+
+        items.clear();
+    }
+
+    void close()
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(mutex_);
+
+        closed_ = true;
+        clear(items_);
+        clear(returned_);
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    const std::thread::id owner_;
+
+    // These are used only by the owner, except on close.
+    std::vector<Item> items_;
+
+    // These are protected by mutex.
+    bool closed_;
+    std::vector<Item> returned_;
+    mutable shared_mutex mutex_;
+};
+
+/// A block freelist shared by the recycling allocators of each thread.
+/// Blocks are of one size, large enough for the control block of a pooled
+/// message pointer, so a rebound allocator shares the list it was copied
+/// from.
+struct recycled_block
+{
+    static const size_t size = 128;
+
+    void operator()(void* block) const
+    {
+        ::operator delete(block);
+    }
+};
+
+typedef thread_freelist<void*, recycled_block> recycled_blocks;
+
+/// Allocates single objects from the block freelist of the constructing
+/// thread, used for the control blocks of pooled message pointers. A block
+/// is returned to that list by whichever thread deallocates it.
+template <typename Type>
+class recycling_allocator
+{
+public:
+    typedef Type value_type;
+
+    recycling_allocator()
+      : list_(recycled_blocks::local())
+    {
+    }
+
+    template <typename Other>
+    recycling_allocator(const recycling_allocator<Other>& other)
+      : list_(other.list())
+    {
+    }
+
+    Type* allocate(size_t count)
+    {
+        const auto block = recycled(count) ? list_->pop() : nullptr;
+        return static_cast<Type*>(block != nullptr ? block :
+            ::operator new(recycled(count) ? recycled_block::size :
+                count * sizeof(Type)));
+    }
+
+    void deallocate(Type* block, size_t count)
+    {
+        if (!recycled(count) || !list_->push(block))
+            ::operator delete(block);
+    }
+
+    const recycled_blocks::ptr& list() const
+    {
+        return list_;
+    }
+
+    template <typename Other>
+    bool operator==(const recycling_allocator<Other>&) const
+    {
+        return true;
+    }
+
+    template <typename Other>
+    bool operator!=(const recycling_allocator<Other>&) const
+    {
+        return false;
+    }
+
+private:
+    bool recycled(size_t count) const
+    {
+        return list_ && count == 1 && sizeof(Type) <= recycled_block::size;
+    }
+
+    recycled_blocks::ptr list_;
+};
+
+/// Restore a recycled message to its default state.
+template <class Message>
+void recycle_reset(Message& instance)
+{
+    instance.reset();
+}
+
+/// A recycled buffer is emptied, retaining its capacity.
+inline void recycle_reset(data_chunk& instance)
+{
+    instance.clear();
+}
+
+/// Recycles instances of a message type through per-thread freelists. The
+/// deleter of an acquired pointer returns the instance to the freelist of
+/// the acquiring thread, from any thread, and its control block is recycled
+/// alike. Messages decoded on a network thread and released by a handler
+/// thread are thereby reused by the network thread.
+template <class Message>
+class message_pool
+{
+public:
+    typedef std::shared_ptr<Message> ptr;
+
+    /// A reset instance from the freelist of this thread, or a new instance.
+    static ptr acquire()
+    {
+        auto list = instances::local();
+        auto instance = list ? list->pop() : nullptr;
+
+        if (instance == nullptr)
+            instance = new Message;
+        else
+            recycle_reset(*instance);
+
+        return ptr(instance, recycle{ std::move(list) },
+            recycling_allocator<Message>());
+    }
+
+private:
+    struct release
+    {
+        void operator()(Message* instance) const
+        {
+            delete instance;
+        }
+    };
+
+    typedef thread_freelist<Message*, release> instances;
+
+    struct recycle
+    {
+        void operator()(Message* instance) const
+        {
+            if (!list || !list->push(instance))
+                delete instance;
+        }
+
+        typename instances::ptr list;
+    };
+};
+
+/// Small messages received at high frequency are recycled.
+template <class Message>
+struct is_pooled
+  : std::false_type
+{
+};
+
+template <> struct is_pooled<message::address> : std::true_type {};
+template <> struct is_pooled<message::get_data> : std::true_type {};
+template <> struct is_pooled<message::inventory> : std::true_type {};
+template <> struct is_pooled<message::ping> : std::true_type {};
+template <> struct is_pooled<message::pong> : std::true_type {};
+template <> struct is_pooled<message::verack> : std::true_type {};
+
+/// Construct a message for decode, from its pool if the type is pooled.
+template <class Message>
+typename std::enable_if<is_pooled<Message>::value,
+    std::shared_ptr<Message>>::type make_message()
+{
+    return message_pool<Message>::acquire();
+}
+
+template <class Message>
+typename std::enable_if<!is_pooled<Message>::value,
+    std::shared_ptr<Message>>::type make_message()
+{
+    return std::make_shared<Message>();
+}
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -19,6 +19,8 @@
 #ifndef LIBBITCOIN_NETWORK_MESSAGE_SUBSCRIBER_HPP
 #define LIBBITCOIN_NETWORK_MESSAGE_SUBSCRIBER_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <istream>
 #include <functional>
 #include <map>
@@ -26,29 +28,49 @@
 #include <utility>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/block_decoder.hpp>
+#include <bitcoin/network/connection_slab.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/message_pool.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
+#include <bitcoin/network/snapshot_resubscriber.hpp>
+#include <bitcoin/network/wire_payload.hpp>
 
 namespace libbitcoin {
 namespace network {
 
 #define DEFINE_SUBSCRIBER_TYPE(value) \
-    typedef resubscriber<code, message::value::const_ptr> \
+    typedef snapshot_resubscriber<code, message::value::const_ptr> \
         value##_subscriber_type
 
 #define DEFINE_SUBSCRIBER_OVERLOAD(value) \
     template <typename Handler> \
     void subscribe(message::value&&, Handler&& handler) \
     { \
+        decoded_ |= to_bit(message::message_type::value); \
         value##_subscriber_->subscribe(std::forward<Handler>(handler), \
             error::channel_stopped, {}); \
     }
 
+#define DEFINE_INLINE_OVERLOAD(value) \
+    template <typename Handler> \
+    void subscribe_inline(message::value&&, Handler&& handler) \
+    { \
+        decoded_ |= to_bit(message::message_type::value); \
+        value##_inline_subscriber_->subscribe( \
+            std::forward<Handler>(handler), error::channel_stopped, {}); \
+        inline_ |= to_bit(message::message_type::value); \
+    }
+
 #define DECLARE_SUBSCRIBER(value) \
     value##_subscriber_type::ptr value##_subscriber_
 
+#define DECLARE_INLINE_SUBSCRIBER(value) \
+    value##_subscriber_type::ptr value##_inline_subscriber_
+
 template <class Message>
 using message_handler =
-    std::function<bool(const code&, std::shared_ptr<const Message>)>;
+    unique_function<bool(const code&, std::shared_ptr<const Message>)>;
 
 /// Aggregation of subscribers by messasge type, thread safe.
 class BCT_API message_subscriber
@@ -83,11 +105,33 @@ public:
     DEFINE_SUBSCRIBER_TYPE(verack);
     DEFINE_SUBSCRIBER_TYPE(version);
 
+    typedef priority_dispatcher::priority priority;
+    typedef std::function<void(const code&)> result_handler;
+    typedef std::shared_ptr<const data_chunk> payload_ptr;
+    typedef unique_function<bool(const code&, const message::heading&,
+        payload_ptr)> raw_handler;
+    typedef snapshot_resubscriber<code, message::heading, payload_ptr>
+        raw_subscriber_type;
+
     /**
      * Create an instance of this class.
-     * @param[in]  pool  The threadpool to use for sending notifications.
+     * @param[in]  pool       The threadpool to use for sending notifications.
+     * @param[in]  dispatch   The prioritized queues for relayed messages.
+     * @param[in]  allocator  The allocator of the connection subscribers.
+     * @param[in]  ordered    Relay messages in arrival order, one at a time,
+     *                        otherwise in arrival order within each lane.
+     * @param[in]  ahead      Pipelined types may be loaded behind the reader.
+     * @param[in]  parallel   Parse large block transactions in parallel.
+     * @param[in]  retain     Retain block and transaction wire payloads.
      */
-    message_subscriber(threadpool& pool);
+    message_subscriber(threadpool& pool, priority_dispatcher& dispatch,
+        const connection_slab::byte_allocator& allocator, bool ordered,
+        bool ahead, bool parallel, bool retain);
+
+    /// True if the message type is decoded from its payload bytes, caching
+    /// the hashes computed from them, in place or behind the reader (see
+    /// decode and load).
+    static bool pipelined(message::message_type type);
 
     /**
      * Subscribe to receive a notification when a message of type is received.
@@ -102,49 +146,170 @@ public:
     }
 
     /**
-     * Load a stream into a message instance and notify subscribers.
-     * @param[in]  stream      The stream from which to load the message.
+     * Subscribe to receive a notification ahead of other subscribers. This is
+     * on the reading thread, before the message is queued, except for
+     * pipelined types read ahead (see load), where it is in the decode job on
+     * the handler pool, before the subscribers of that job. Either way the
+     * handler must be cheap and must not block, as it delays the next read
+     * or the channel's next decode.
+     * The handler is unregistered when the call is made.
+     * @param[in]  handler  The handler to register.
+     */
+    template <class Message, typename Handler>
+    void subscribe_inline(Handler&& handler)
+    {
+        subscribe_inline(Message(), std::forward<Handler>(handler));
+    }
+
+    /**
+     * Subscribe to receive the undecoded payloads of a message type.
+     * A type with only raw subscribers is not decoded (see decoded).
+     * The handler is unregistered when the call is made.
+     * @param[in]  type     The message type to receive.
+     * @param[in]  handler  The handler to register.
+     */
+    void subscribe_raw(message::message_type type, raw_handler&& handler);
+
+    /// True if the message type has been subscribed raw.
+    bool raw(message::message_type type) const;
+
+    /// True if the message type has been subscribed decoded (or inline).
+    bool decoded(message::message_type type) const;
+
+    /// True if messages of the type retain their wire payload (see decode).
+    bool retained(message::message_type type) const;
+
+    /**
+     * Queue notification of raw subscribers with a shared payload.
+     * @param[in]  head     The message heading.
+     * @param[in]  payload  The message payload, never modified.
+     * @param[in]  resume   Invoked once the handler queues have capacity.
+     */
+    void relay_raw(const message::heading& head, payload_ptr payload,
+        priority_dispatcher::job&& resume) const;
+
+    /**
+     * Load a message instance and queue subscriber notification.
+     * The resume handler is invoked once the handler queues have capacity.
+     * @param[in]  type        The message type identifier.
+     * @param[in]  source      The stream or payload from which to load.
      * @param[in]  version     The peer protocol version.
      * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  inline_subscriber  The inline subscriber for the type.
+     * @param[in]  lane        The dispatch priority of the message type.
+     * @param[in]  resume      Invoked to resume reading, only on success.
      * @return                 Returns error::bad_stream if failed.
      */
-    template <class Message, class Subscriber>
-    code relay(std::istream& stream, uint32_t version,
-        Subscriber& subscriber) const
+    template <class Message, class Subscriber, class Source>
+    code relay(message::message_type type, Source& source, uint32_t version,
+        Subscriber& subscriber, Subscriber& inline_subscriber,
+        priority lane, priority_dispatcher::job&& resume) const
     {
-        const auto message = std::make_shared<Message>();
+        auto message = load_message<Message>(type, version, source);
 
         // Subscribers are invoked only with stop and success codes.
-        if (!message->from_data(version, stream))
+        if (!message)
             return error::bad_stream;
 
-        ////const auto const_ptr = std::const_pointer_cast<const Message>(message);
-        subscriber->relay(error::success, message);
+        // Inline subscribers run on the reading thread, ahead of the queue.
+        typename Message::const_ptr const_ptr(std::move(message));
+
+        if (inlined(type))
+            inline_subscriber->invoke(error::success, const_ptr);
+
+        // Subscribers are invoked in sequence on the dispatched job.
+        post(lane, [subscriber, const_ptr = std::move(const_ptr)]()
+        {
+            subscriber->invoke(error::success, const_ptr);
+        });
+
+        // Reading is paused while the handler queues are full.
+        dispatch_.resume(std::move(resume));
         return error::success;
     }
 
     /**
-     * Load a stream into a message instance and invoke subscribers.
-     * @param[in]  stream      The stream from which to load the message.
+     * Load a message instance and queue subscriber notification.
+     * The resume handler is invoked once all subscribers have been invoked.
+     * @param[in]  type        The message type identifier.
+     * @param[in]  source      The stream or payload from which to load.
      * @param[in]  version     The peer protocol version.
      * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  inline_subscriber  The inline subscriber for the type.
+     * @param[in]  lane        The dispatch priority of the message type.
+     * @param[in]  resume      Invoked to resume reading, only on success.
      * @return                 Returns error::bad_stream if failed.
      */
-    template <class Message, class Subscriber>
-    code handle(std::istream& stream, uint32_t version,
-        Subscriber& subscriber) const
+    template <class Message, class Subscriber, class Source>
+    code handle(message::message_type type, Source& source, uint32_t version,
+        Subscriber& subscriber, Subscriber& inline_subscriber,
+        priority lane, priority_dispatcher::job&& resume) const
     {
-        const auto message = std::make_shared<Message>();
+        auto message = load_message<Message>(type, version, source);
 
         // Subscribers are invoked only with stop and success codes.
-        if (!message->from_data(version, stream))
+        if (!message)
             return error::bad_stream;
 
-        ////const auto const_ptr = std::const_pointer_cast<const Message>(message);
-        subscriber->invoke(error::success, message);
+        typename Message::const_ptr const_ptr(std::move(message));
+
+        if (inlined(type))
+            inline_subscriber->invoke(error::success, const_ptr);
+
+        // The peer is not read while the message is handled, but the reading
+        // thread is released to other sockets.
+        post(lane, [subscriber, const_ptr = std::move(const_ptr),
+            resume = std::move(resume)]()
+        {
+            subscriber->invoke(error::success, const_ptr);
+            resume();
+        });
+
         return error::success;
     }
 
+    /**
+     * Queue decode of an owned payload and invocation of subscribers, in
+     * order with other bulk messages of the channel. Inline subscribers
+     * are invoked by the job, not the reading thread.
+     * @param[in]  type        The payload message type identifier.
+     * @param[in]  version     The peer protocol version.
+     * @param[in]  payload     The message payload, released after decode.
+     * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  inline_subscriber  The inline subscriber for the type.
+     * @param[in]  complete    Invoked with error::bad_stream if decode failed.
+     */
+    template <class Message, class Subscriber>
+    void pipeline(message::message_type type, uint32_t version,
+        payload_ptr payload, Subscriber& subscriber,
+        Subscriber& inline_subscriber, result_handler&& complete) const
+    {
+        // The payload and completion are moved, not copied, into the job.
+        bulk_->post(priority::bulk,
+            [this, type, version, payload = std::move(payload), subscriber,
+                inline_subscriber, complete = std::move(complete)]() mutable
+            {
+                const auto message = load_message<Message>(type, version,
+                    payload);
+
+                if (!message)
+                {
+                    complete(error::bad_stream);
+                    return;
+                }
+
+                payload.reset();
+                typename Message::const_ptr const_ptr(message);
+
+                // The reader has moved on, inline is only ahead of the queue.
+                if (inlined(type))
+                    inline_subscriber->invoke(error::success, const_ptr);
+
+                subscriber->invoke(error::success, const_ptr);
+                complete(error::success);
+            });
+    }
+
     /**
      * Broadcast a default message instance with the specified error code.
      * @param[in]  ec  The error code to broadcast.
@@ -158,10 +323,51 @@ public:
      * @param[in]  type     The stream message type identifier.
      * @param[in]  version  The peer protocol version.
      * @param[in]  stream   The stream from which to load the message.
+     * @param[in]  resume   Invoked when the next message may be read.
      * @return              Returns error::bad_stream if failed.
      */
     virtual code load(message::message_type type, uint32_t version,
-        std::istream& stream) const;
+        std::istream& stream, priority_dispatcher::job&& resume) const;
+
+    /*
+     * Decode the payload of a pipelined message type in place, caching the
+     * hashes computed from its bytes, and notify as load of a stream.
+     * @param[in]  type     The payload message type identifier.
+     * @param[in]  version  The peer protocol version.
+     * @param[in]  payload  The message payload, not referenced after return.
+     * @param[in]  resume   Invoked when the next message may be read.
+     * @return              Returns error::bad_stream if failed, including
+     *                      on trailing bytes.
+     */
+    virtual code decode(message::message_type type, uint32_t version,
+        const data_chunk& payload, priority_dispatcher::job&& resume) const;
+
+    /*
+     * Decode a shared payload of a pipelined message type in place, as
+     * decode of a payload, retaining it with the message if the type is
+     * retained (see retained), so that the message is forwarded without
+     * serialization.
+     * @param[in]  type     The payload message type identifier.
+     * @param[in]  version  The peer protocol version.
+     * @param[in]  payload  The message payload, never modified.
+     * @param[in]  resume   Invoked when the next message may be read.
+     * @return              Returns error::bad_stream if failed.
+     */
+    virtual code decode(message::message_type type, uint32_t version,
+        payload_ptr payload, priority_dispatcher::job&& resume) const;
+
+    /*
+     * Queue decode and notification of a pipelined message type, used when
+     * the channel reads ahead (see constructor), failing with
+     * error::operation_failed otherwise. Inline subscribers run in the
+     * decode job.
+     * @param[in]  type      The payload message type identifier.
+     * @param[in]  version   The peer protocol version.
+     * @param[in]  payload   The message payload.
+     * @param[in]  complete  Invoked after subscribers or on decode failure.
+     */
+    virtual void load(message::message_type type, uint32_t version,
+        payload_ptr payload, result_handler&& complete) const;
 
     /**
      * Start all subscribers so that they accept subscription.
@@ -174,6 +380,74 @@ public:
     virtual void stop();
 
 private:
+    // A stream is parsed, a payload is decoded with its hashes (see decode).
+    template <class Message>
+    std::shared_ptr<Message> load_message(message::message_type,
+        uint32_t version, std::istream& stream) const
+    {
+        const auto message = make_message<Message>();
+        return message->from_data(version, stream) ? message : nullptr;
+    }
+
+    template <class Message>
+    std::shared_ptr<Message> load_message(message::message_type,
+        uint32_t version, const data_chunk& payload) const
+    {
+        const auto message = make_message<Message>();
+        return decode(*message, version, payload) ? message : nullptr;
+    }
+
+    // A retained payload is released with the message.
+    template <class Message>
+    std::shared_ptr<Message> load_message(message::message_type type,
+        uint32_t version, const payload_ptr& payload) const
+    {
+        const auto wire = retained(type) ?
+            std::make_shared<wire_payload>(payload) : nullptr;
+        const auto message = wire ? wire_payload::allocate<Message>(wire) :
+            make_message<Message>();
+
+        if (!decode(*message, version, *payload))
+            return nullptr;
+
+        if (wire)
+            wire->set_portable(!block_decoder::segregated(type, *payload));
+
+        return message;
+    }
+
+    // Blocks, transactions and headers cache hashes computed from the
+    // payload. Trailing bytes are invalid, as on the read path.
+    bool decode(message::block& message, uint32_t version,
+        const data_chunk& payload) const;
+    bool decode(message::transaction& message, uint32_t version,
+        const data_chunk& payload) const;
+    bool decode(message::headers& message, uint32_t version,
+        const data_chunk& payload) const;
+
+    void post(priority lane, priority_dispatcher::job&& handler) const;
+    bool inlined(message::message_type type) const;
+
+    // Subscriptions are never removed from the sets, so these only grow.
+    static uint32_t to_bit(message::message_type type)
+    {
+        return uint32_t(1) << static_cast<uint32_t>(type);
+    }
+
+    priority_dispatcher& dispatch_;
+    const bool retain_;
+    std::atomic<uint32_t> decoded_;
+    std::atomic<uint32_t> inline_;
+    std::atomic<uint32_t> raw_;
+    raw_subscriber_type::ptr raw_subscriber_;
+
+    // The messages of a channel are handled in arrival order on each lane,
+    // and control runs ahead of bulk. Ordered relay shares one strand.
+    const bool ahead_;
+    priority_dispatcher::strand::ptr control_;
+    priority_dispatcher::strand::ptr bulk_;
+    block_decoder decoder_;
+
     DEFINE_SUBSCRIBER_OVERLOAD(address);
     DEFINE_SUBSCRIBER_OVERLOAD(alert);
     DEFINE_SUBSCRIBER_OVERLOAD(block);
@@ -202,6 +476,34 @@ private:
     DEFINE_SUBSCRIBER_OVERLOAD(verack);
     DEFINE_SUBSCRIBER_OVERLOAD(version);
 
+    DEFINE_INLINE_OVERLOAD(address);
+    DEFINE_INLINE_OVERLOAD(alert);
+    DEFINE_INLINE_OVERLOAD(block);
+    DEFINE_INLINE_OVERLOAD(block_transactions);
+    DEFINE_INLINE_OVERLOAD(compact_block);
+    DEFINE_INLINE_OVERLOAD(fee_filter);
+    DEFINE_INLINE_OVERLOAD(filter_add);
+    DEFINE_INLINE_OVERLOAD(filter_clear);
+    DEFINE_INLINE_OVERLOAD(filter_load);
+    DEFINE_INLINE_OVERLOAD(get_address);
+    DEFINE_INLINE_OVERLOAD(get_blocks);
+    DEFINE_INLINE_OVERLOAD(get_block_transactions);
+    DEFINE_INLINE_OVERLOAD(get_data);
+    DEFINE_INLINE_OVERLOAD(get_headers);
+    DEFINE_INLINE_OVERLOAD(headers);
+    DEFINE_INLINE_OVERLOAD(inventory);
+    DEFINE_INLINE_OVERLOAD(memory_pool);
+    DEFINE_INLINE_OVERLOAD(merkle_block);
+    DEFINE_INLINE_OVERLOAD(not_found);
+    DEFINE_INLINE_OVERLOAD(ping);
+    DEFINE_INLINE_OVERLOAD(pong);
+    DEFINE_INLINE_OVERLOAD(reject);
+    DEFINE_INLINE_OVERLOAD(send_compact);
+    DEFINE_INLINE_OVERLOAD(send_headers);
+    DEFINE_INLINE_OVERLOAD(transaction);
+    DEFINE_INLINE_OVERLOAD(verack);
+    DEFINE_INLINE_OVERLOAD(version);
+
     DECLARE_SUBSCRIBER(address);
     DECLARE_SUBSCRIBER(alert);
     DECLARE_SUBSCRIBER(block);
@@ -229,11 +531,41 @@ private:
     DECLARE_SUBSCRIBER(transaction);
     DECLARE_SUBSCRIBER(verack);
     DECLARE_SUBSCRIBER(version);
+
+    DECLARE_INLINE_SUBSCRIBER(address);
+    DECLARE_INLINE_SUBSCRIBER(alert);
+    DECLARE_INLINE_SUBSCRIBER(block);
+    DECLARE_INLINE_SUBSCRIBER(block_transactions);
+    DECLARE_INLINE_SUBSCRIBER(compact_block);
+    DECLARE_INLINE_SUBSCRIBER(fee_filter);
+    DECLARE_INLINE_SUBSCRIBER(filter_add);
+    DECLARE_INLINE_SUBSCRIBER(filter_clear);
+    DECLARE_INLINE_SUBSCRIBER(filter_load);
+    DECLARE_INLINE_SUBSCRIBER(get_address);
+    DECLARE_INLINE_SUBSCRIBER(get_blocks);
+    DECLARE_INLINE_SUBSCRIBER(get_block_transactions);
+    DECLARE_INLINE_SUBSCRIBER(get_data);
+    DECLARE_INLINE_SUBSCRIBER(get_headers);
+    DECLARE_INLINE_SUBSCRIBER(headers);
+    DECLARE_INLINE_SUBSCRIBER(inventory);
+    DECLARE_INLINE_SUBSCRIBER(memory_pool);
+    DECLARE_INLINE_SUBSCRIBER(merkle_block);
+    DECLARE_INLINE_SUBSCRIBER(not_found);
+    DECLARE_INLINE_SUBSCRIBER(ping);
+    DECLARE_INLINE_SUBSCRIBER(pong);
+    DECLARE_INLINE_SUBSCRIBER(reject);
+    DECLARE_INLINE_SUBSCRIBER(send_compact);
+    DECLARE_INLINE_SUBSCRIBER(send_headers);
+    DECLARE_INLINE_SUBSCRIBER(transaction);
+    DECLARE_INLINE_SUBSCRIBER(verack);
+    DECLARE_INLINE_SUBSCRIBER(version);
 };
 
 #undef DEFINE_SUBSCRIBER_TYPE
 #undef DEFINE_SUBSCRIBER_OVERLOAD
+#undef DEFINE_INLINE_OVERLOAD
 #undef DECLARE_SUBSCRIBER
+#undef DECLARE_INLINE_SUBSCRIBER
 
 } // namespace network
 } // namespace libbitcoin
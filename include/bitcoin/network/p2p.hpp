@@ -28,14 +28,22 @@
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connection_slab.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/memory_governor.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/payload_cache.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/sessions/session_inbound.hpp>
 #include <bitcoin/network/sessions/session_manual.hpp>
 #include <bitcoin/network/sessions/session_outbound.hpp>
 #include <bitcoin/network/sessions/session_seed.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/snapshot_resubscriber.hpp>
+#include <bitcoin/network/thread_placement.hpp>
+#include <bitcoin/network/thread_scaler.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -55,7 +63,7 @@ public:
     typedef std::function<void(const code&, channel::ptr)> channel_handler;
     typedef std::function<bool(const code&, channel::ptr)> connect_handler;
     typedef subscriber<code> stop_subscriber;
-    typedef resubscriber<code, channel::ptr> channel_subscriber;
+    typedef snapshot_resubscriber<code, channel::ptr> channel_subscriber;
 
     // Templates (send/receive).
     // ------------------------------------------------------------------------
@@ -78,6 +86,24 @@ public:
                 std::placeholders::_1, channel, handle_channel, join_handler));
     }
 
+    /// Send a received message to all connections, forwarding its retained
+    /// wire payload where the encoding is independent of the peer.
+    template <typename Message>
+    void broadcast(std::shared_ptr<const Message> message,
+        channel_handler handle_channel, result_handler handle_complete)
+    {
+        // Safely copy the channel collection.
+        const auto channels = pending_close_.collection();
+
+        // Invoke the completion handler after send complete on all channels.
+        const auto join_handler = synchronize(handle_complete, channels.size(),
+            "p2p_join", synchronizer_terminate::on_count);
+
+        for (const auto channel: channels)
+            channel->send(message, std::bind(&p2p::handle_send, this,
+                std::placeholders::_1, channel, handle_channel, join_handler));
+    }
+
     // Constructors.
     // ------------------------------------------------------------------------
 
@@ -127,9 +153,30 @@ public:
     /// Determine if the network is stopped.
     virtual bool stopped() const;
 
-    /// Return a reference to the network threadpool.
+    /// Return a reference to the network (socket and timer) threadpool.
     virtual threadpool& thread_pool();
 
+    /// Return a reference to the threadpool of decoded message handlers.
+    virtual threadpool& handler_pool();
+
+    /// Return a reference to the timing wheel shared by all channels.
+    virtual timer_wheel& timers();
+
+    /// Return a reference to the prioritized message dispatch queues.
+    virtual priority_dispatcher& lanes();
+
+    /// Return a reference to the adaptive handler thread count.
+    virtual thread_scaler& scaler();
+
+    /// Return a reference to the relayed payloads shared by all channels.
+    virtual payload_cache& payloads();
+
+    /// Return a reference to the per-connection allocation slab.
+    virtual connection_slab& slab();
+
+    /// Return a reference to the memory accounting of the network.
+    virtual memory_governor& governor();
+
     // Subscriptions.
     // ------------------------------------------------------------------------
 
@@ -239,12 +286,23 @@ private:
     void handle_started(const code& ec, result_handler handler);
     void handle_running(const code& ec, result_handler handler);
 
+    void handle_memory_pressure();
+    void evict_channels();
+
     // These are thread safe.
     const settings& settings_;
     std::atomic<bool> stopped_;
     bc::atomic<config::checkpoint> top_block_;
     bc::atomic<session_manual::ptr> manual_;
     threadpool threadpool_;
+    threadpool handler_pool_;
+    timer_wheel timers_;
+    priority_dispatcher lanes_;
+    const thread_placement placement_;
+    thread_scaler scaler_;
+    payload_cache payloads_;
+    connection_slab slab_;
+    memory_governor governor_;
     hosts hosts_;
     pending_connectors pending_connect_;
     pending_channels pending_handshake_;
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PAYLOAD_CACHE_HPP
+#define LIBBITCOIN_NETWORK_PAYLOAD_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A bounded record of recently relayed payloads shared by all channels, so
+/// that a payload relayed by several peers is decoded and handled only once.
+/// Entries are keyed on message type, wire checksum and length, which are
+/// not trusted, and are confirmed by a sample of the payload bytes and then
+/// by the payload hash. The first payload of each key is hashed, and a repeat
+/// only if its sample matches, so a payload is dropped from its first repeat.
+/// Thread safe.
+class BCT_API payload_cache
+  : noncopyable
+{
+public:
+    /// Construct a cache of the given entry capacity, zero disables.
+    payload_cache(size_t capacity);
+
+    /// True if the cache retains entries.
+    bool enabled() const;
+
+    /**
+     * Record a payload, true if it duplicates a payload already relayed.
+     * A payload that is not a duplicate is expected to be relayed.
+     * @param[in]  type      The payload message type identifier.
+     * @param[in]  checksum  The checksum of the message heading.
+     * @param[in]  payload   The message payload.
+     * @return               True if the payload should be dropped.
+     */
+    bool duplicate(message::message_type type, uint32_t checksum,
+        const data_chunk& payload);
+
+    /// The number of lookups, including misses.
+    uint64_t lookups() const;
+
+    /// The number of lookups that found a duplicate.
+    uint64_t hits() const;
+
+private:
+    static const size_t sample_size = 32;
+
+    typedef std::tuple<message::message_type, uint32_t, size_t> key;
+    typedef std::array<uint8_t, 2 * sample_size> sample;
+
+    struct entry
+    {
+        sample bytes;
+        hash_digest digest;
+        bool hashed;
+        uint64_t sequence;
+    };
+
+    /// One independently locked part of the cache.
+    class shard
+    {
+    public:
+        shard(size_t capacity);
+
+        bool duplicate(const key& value, const data_chunk& payload);
+
+    private:
+        uint64_t store(const key& value, const sample& bytes);
+        void hash(const key& value, uint64_t sequence,
+            const data_chunk& payload);
+
+        const size_t capacity_;
+
+        // These are protected by mutex.
+        uint64_t sequence_;
+        std::map<key, entry> entries_;
+        std::deque<std::pair<key, uint64_t>> order_;
+        shared_mutex mutex_;
+    };
+
+    static sample to_sample(const data_chunk& payload);
+    shard& select(uint32_t checksum);
+
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<uint64_t> lookups_;
+    std::atomic<uint64_t> hits_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
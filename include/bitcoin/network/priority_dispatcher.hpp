@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PRIORITY_DISPATCHER_HPP
+#define LIBBITCOIN_NETWORK_PRIORITY_DISPATCHER_HPP
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/unique_function.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Prioritized handler queues executed on the handler threadpool.
+/// At most one queued job per thread is scheduled on the pool at a time, and
+/// control jobs always run ahead of queued bulk jobs. The queues, including
+/// the jobs waiting on strands, are bounded by deferring the readers that fill
+/// them (see resume), thread safe.
+class BCT_API priority_dispatcher
+  : noncopyable
+{
+public:
+    typedef unique_function<void()> job;
+
+    enum class priority
+    {
+        /// Handshake, ping and timer work, always dequeued first.
+        control,
+
+        /// Payload handling (blocks, transactions, inventory, etc).
+        bulk
+    };
+
+    /// Jobs posted to a strand run one at a time in posted order, on the
+    /// lane of each job, while separate strands run in parallel.
+    class BCT_API strand
+      : public enable_shared_from_base<strand>, noncopyable
+    {
+    public:
+        typedef std::shared_ptr<strand> ptr;
+
+        /// Construct an instance.
+        strand(priority_dispatcher& dispatch);
+
+        /// Queue a job behind all jobs previously posted to this strand.
+        void post(priority lane, job&& handler);
+
+    private:
+        typedef std::deque<std::pair<priority, job>> queue;
+
+        void run();
+
+        priority_dispatcher& dispatch_;
+
+        // These are protected by mutex.
+        bool running_;
+        queue queue_;
+        mutable shared_mutex mutex_;
+    };
+
+    /// Construct an instance, with zero capacity the queues are unbounded.
+    priority_dispatcher(threadpool& pool, size_t concurrency,
+        size_t capacity);
+
+    /// Queue a job on the specified lane.
+    void post(priority lane, job&& handler);
+
+    /// Invoke the handler now if the queues are below capacity, otherwise
+    /// once they drain below capacity (on the thread that drains them).
+    void resume(job&& handler);
+
+    /// Change the number of jobs that may be scheduled on the pool at once.
+    void set_concurrency(size_t concurrency);
+
+    /// The threadpool on which jobs are executed.
+    threadpool& pool();
+
+    /// The number of jobs waiting on the specified lane.
+    size_t size(priority lane) const;
+
+private:
+    typedef std::deque<job> queue;
+    static const size_t lanes = 2;
+
+    void schedule();
+    void run();
+    void strand_posted();
+    void strand_taken();
+    void take_waiting(queue& resumed);
+
+    threadpool& pool_;
+    const size_t capacity_;
+
+    // These are protected by mutex.
+    size_t concurrency_;
+    size_t scheduled_;
+    size_t queued_;
+    size_t stranded_;
+    queue waiting_;
+    std::array<queue, lanes> queues_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -26,6 +26,7 @@
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/unique_function.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -52,7 +53,7 @@ class BCT_API protocol
 {
 protected:
     typedef std::function<void()> completion_handler;
-    typedef std::function<void(const code&)> event_handler;
+    typedef unique_function<void(const code&)> event_handler;
     typedef std::function<void(const code&, size_t)> count_handler;
 
     /// Construct an instance.
@@ -86,6 +87,23 @@ protected:
         channel_->template subscribe<Message>(BOUND_PROTOCOL(handler, args));
     }
 
+    /// Subscribe to channel messages ahead of other handlers (cheap handlers),
+    /// on the reading thread unless the message is read ahead.
+    template <class Protocol, class Message, typename Handler, typename... Args>
+    void subscribe_inline(Handler&& handler, Args&&... args)
+    {
+        channel_->template subscribe_inline<Message>(
+            BOUND_PROTOCOL(handler, args));
+    }
+
+    /// Subscribe to undecoded channel payloads of the message type.
+    template <class Protocol, typename Handler, typename... Args>
+    void subscribe_raw(message::message_type type, Handler&& handler,
+        Args&&... args)
+    {
+        channel_->subscribe_raw(type, BOUND_PROTOCOL(handler, args));
+    }
+
     /// Subscribe to the channel stop, blocking until subscribed.
     template <class Protocol, typename Handler, typename... Args>
     void subscribe_stop(Handler&& handler, Args&&... args)
@@ -147,6 +165,14 @@ private:
 #define SUBSCRIBE3(message, method, p1, p2, p3) \
     subscribe<CLASS, message>(&CLASS::method, p1, p2, p3)
 
+#define SUBSCRIBE_INLINE2(message, method, p1, p2) \
+    subscribe_inline<CLASS, message>(&CLASS::method, p1, p2)
+#define SUBSCRIBE_INLINE3(message, method, p1, p2, p3) \
+    subscribe_inline<CLASS, message>(&CLASS::method, p1, p2, p3)
+
+#define SUBSCRIBE_RAW3(type, method, p1, p2, p3) \
+    subscribe_raw<CLASS>(type, &CLASS::method, p1, p2, p3)
+
 #define SUBSCRIBE_STOP1(method, p1) \
     subscribe_stop<CLASS>(&CLASS::method, p1)
 
@@ -19,6 +19,7 @@
 #ifndef LIBBITCOIN_NETWORK_PROTOCOL_EVENTS_HPP
 #define LIBBITCOIN_NETWORK_PROTOCOL_EVENTS_HPP
 
+#include <memory>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
@@ -80,7 +81,8 @@ private:
     void handle_stopped(const code& ec);
     void do_set_event(const code& ec);
 
-    bc::atomic<event_handler> handler_;
+    // The handler is move-only, so it is shared with each invocation.
+    bc::atomic<std::shared_ptr<const event_handler>> handler_;
 };
 
 } // namespace network
@@ -60,7 +60,7 @@ protected:
     virtual void handle_send_get_address(const code& ec);
     virtual void handle_store_addresses(const code& ec);
     virtual void handle_seeding_complete(const code& ec,
-        event_handler handler);
+        const event_handler& handler);
 
     virtual bool handle_receive_address(const code& ec,
         address_const_ptr address);
@@ -24,6 +24,7 @@
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -62,10 +63,11 @@ protected:
 
 private:
     void handle_timer(const code& ec);
-    void handle_notify(const code& ec, event_handler handler);
+    void handle_notify(const code& ec, const event_handler& handler);
 
     const bool perpetual_;
-    deadline::ptr timer_;
+    timer_wheel& timers_;
+    timer_wheel::timer::ptr timer_;
 };
 
 } // namespace network
@@ -25,11 +25,19 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/connection_slab.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/memory_governor.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/payload_cache.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/unique_function.hpp>
+#include <bitcoin/network/wire_payload.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -42,27 +50,68 @@ public:
     typedef std::shared_ptr<proxy> ptr;
     typedef std::function<void(const code&)> result_handler;
     typedef subscriber<code> stop_subscriber;
+    typedef std::shared_ptr<data_chunk> buffer_ptr;
+    typedef unique_function<void(const code&)> send_handler;
 
     /// Construct an instance.
-    proxy(threadpool& pool, socket::ptr socket, const settings& settings);
+    proxy(threadpool& pool, socket::ptr socket, priority_dispatcher& dispatch,
+        payload_cache& payloads,
+        const connection_slab::byte_allocator& allocator,
+        memory_governor& governor, const settings& settings);
 
     /// Validate proxy stopped.
     ~proxy();
 
+    /// Serialize a message and its heading into a buffer, recycled if small.
+    template <class Message>
+    static buffer_ptr serialize(const Message& message, uint32_t version,
+        uint32_t magic)
+    {
+        const auto offset = message::heading::satoshi_fixed_size();
+        const auto size = message.serialized_size(version);
+        const auto buffer = make_buffer(offset + size);
+
+        // The payload is written in place, followed by its heading.
+        auto sink = make_unsafe_serializer(buffer->begin() + offset);
+        message.to_data(version, sink);
+        const data_slice payload(buffer->begin() + offset, buffer->end());
+        write_heading(*buffer, message::heading(magic, Message::command,
+            static_cast<uint32_t>(size), bitcoin_checksum(payload)));
+        return buffer;
+    }
+
     /// Send a message on the socket.
     template <class Message>
-    void send(const Message& message, result_handler handler)
+    void send(const Message& message, send_handler handler)
     {
-        auto data = message::serialize(version_, message, protocol_magic_);
-        const auto payload = std::make_shared<data_chunk>(std::move(data));
-        const auto command = std::make_shared<std::string>(message.command);
-
-        // Sequential dispatch is required because write may occur in multiple
-        // asynchronous steps invoked on different threads, causing deadlocks.
-        dispatch_.lock(&proxy::do_send,
-            shared_from_this(), command, payload, handler);
+        enqueue(Message::command, serialize(message, version_,
+            protocol_magic_), nullptr, std::move(handler));
     }
 
+    /// Send a received message, forwarding its retained wire payload if the
+    /// encoding is independent of the peer, otherwise serializing it.
+    template <class Message>
+    void send(std::shared_ptr<const Message> message, send_handler handler)
+    {
+        const auto wire = wire_payload::find(message);
+
+        if (!wire || !wire->portable())
+        {
+            send(*message, std::move(handler));
+            return;
+        }
+
+        // Only the heading is serialized, the payload is written in place.
+        const auto buffer = make_buffer(message::heading::satoshi_fixed_size());
+        write_heading(*buffer, message::heading(protocol_magic_,
+            Message::command, static_cast<uint32_t>(wire->payload().size()),
+            wire->checksum()));
+        enqueue(Message::command, buffer, wire, std::move(handler));
+    }
+
+    /// The memory held by this connection, in bytes.
+    size_t memory_usage() const;
+
     /// Subscribe to messages of the specified type on the socket.
     template <class Message>
     void subscribe(message_handler<Message>&& handler)
@@ -71,6 +120,24 @@ public:
             std::forward<message_handler<Message>>(handler));
     }
 
+    /// Subscribe to messages of the specified type ahead of other handlers,
+    /// on the reading thread unless the type is read ahead (see pipelined).
+    template <class Message>
+    void subscribe_inline(message_handler<Message>&& handler)
+    {
+        message_subscriber_.subscribe_inline<Message>(
+            std::forward<message_handler<Message>>(handler));
+    }
+
+    /// Subscribe to the undecoded payloads of a message type. A type with
+    /// only raw subscribers is not decoded. The payload is shared, immutable.
+    void subscribe_raw(message::message_type type,
+        message_subscriber::raw_handler&& handler)
+    {
+        message_subscriber_.subscribe_raw(type,
+            std::forward<message_subscriber::raw_handler>(handler));
+    }
+
     /// Subscribe to the stop event.
     virtual void subscribe_stop(result_handler handler);
 
@@ -98,43 +165,127 @@ protected:
 private:
     typedef byte_source<data_chunk> payload_source;
     typedef boost::iostreams::stream<payload_source> payload_stream;
-    typedef std::shared_ptr<std::string> command_ptr;
-    typedef std::shared_ptr<data_chunk> payload_ptr;
+
+    /// A message queued for sequential writing.
+    struct outbound
+    {
+        const std::string* command;
+        buffer_ptr data;
+        wire_payload::ptr wire;
+        send_handler handler;
+    };
+
+    /// Storage for the pending write operation, as writes are sequential.
+    class write_memory
+      : noncopyable
+    {
+    public:
+        write_memory();
+        void* allocate(size_t size);
+        void deallocate(void* block);
+
+    private:
+        std::aligned_storage<1024>::type storage_;
+        bool used_;
+    };
+
+    /// The write completion handler, allocating from the write memory.
+    struct write_handler
+    {
+        void operator()(const boost_code& ec, size_t)
+        {
+            self->handle_write(ec, self);
+        }
+
+        void* allocate(size_t size)
+        {
+            return self->write_memory_.allocate(size);
+        }
+
+        void deallocate(void* block)
+        {
+            self->write_memory_.deallocate(block);
+        }
+
+        friend void* asio_handler_allocate(size_t size,
+            write_handler* handler)
+        {
+            return handler->allocate(size);
+        }
+
+        friend void asio_handler_deallocate(void* block, size_t,
+            write_handler* handler)
+        {
+            handler->deallocate(block);
+        }
+
+        ptr self;
+    };
+
+    static buffer_ptr make_buffer(size_t size);
+    static void write_heading(data_chunk& buffer,
+        const message::heading& head);
 
     static config::authority authority_factory(socket::ptr socket);
 
     void do_close();
     void stop(const boost_code& ec);
 
-    void read_heading();
-    void handle_read_heading(const boost_code& ec, size_t payload_size);
+    void read_heading(ptr&& self);
+    void handle_read_heading(const boost_code& ec, ptr&& self);
 
-    void read_payload(const message::heading& head);
-    void handle_read_payload(const boost_code& ec, size_t,
-        const message::heading& head);
+    void read_payload(const message::heading& head, ptr&& self);
+    void handle_read_payload(const boost_code& ec, size_t payload_size,
+        const message::heading& head, ptr&& self);
+    static priority_dispatcher::job resumer(const ptr& self);
+    void resume_read(ptr&& self);
+    message_subscriber::payload_ptr release_payload();
+    message_subscriber::payload_ptr share_payload(data_chunk&& payload);
+    void account_payload();
+    void read_ahead(const message::heading& head,
+        message_subscriber::payload_ptr payload, ptr&& self);
+    void handle_read_ahead(const code& ec, const message::heading& head,
+        ptr&& self);
 
-    void do_send(command_ptr command, payload_ptr payload,
-        result_handler handler);
-    void handle_send(const boost_code& ec, size_t bytes, command_ptr command,
-        payload_ptr payload, result_handler handler);
+    void enqueue(const std::string& command, buffer_ptr data,
+        wire_payload::ptr wire, send_handler&& handler);
+    void write_next(ptr&& self);
+    void handle_write(const boost_code& ec, const ptr& self);
+    void complete_send(const boost_code& ec, const std::string& command,
+        size_t size, const send_handler& handler);
 
     const config::authority authority_;
+    memory_governor& governor_;
+    const memory_governor::account::ptr account_;
+    payload_cache& payloads_;
 
     // These are protected by read header/payload ordering.
     data_chunk heading_buffer_;
     data_chunk payload_buffer_;
+    size_t payload_reserved_;
     socket::ptr socket_;
 
     // These are thread safe.
     std::atomic<bool> stopped_;
+    std::atomic<bool> resuming_;
+    std::atomic<size_t> in_flight_;
+    const size_t pipeline_depth_;
     const uint32_t protocol_magic_;
     const size_t maximum_payload_;
     const bool validate_checksum_;
+    const bool precheck_work_;
     const bool verbose_;
     std::atomic<uint32_t> version_;
     message_subscriber message_subscriber_;
     stop_subscriber::ptr stop_subscriber_;
-    dispatcher dispatch_;
+
+    // These are protected by send_mutex_.
+    std::vector<outbound> sends_;
+    size_t sent_;
+    mutable shared_mutex send_mutex_;
+
+    // This is protected by write sequencing.
+    write_memory write_memory_;
 };
 
 } // namespace network
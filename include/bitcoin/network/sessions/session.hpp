@@ -29,6 +29,7 @@
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/memory_governor.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
 
@@ -128,6 +129,7 @@ protected:
     virtual size_t connection_count() const;
     virtual code fetch_address(address& out_address) const;
     virtual bool blacklisted(const authority& authority) const;
+    virtual memory_governor::pressure memory_pressure() const;
     virtual bool stopped() const;
     virtual bool stopped(const code& ec) const;
 
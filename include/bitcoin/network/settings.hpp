@@ -21,6 +21,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
 
@@ -35,12 +36,31 @@ public:
     settings(config::settings context);
 
     /// Properties.
+    /// The network pool (threads) runs sockets and timers. The handler pool
+    /// (handler_threads) runs message handlers and is scaled by queue depth
+    /// and lag up to thread_maximum handler threads, if greater.
     uint32_t threads;
+    uint32_t thread_maximum;
+    uint32_t handler_threads;
+    uint32_t handler_queue_limit;
+    std::vector<uint32_t> thread_affinity;
+    bool numa_placement;
     uint32_t protocol_maximum;
     uint32_t protocol_minimum;
     uint64_t services;
     uint64_t invalid_services;
     bool relay_transactions;
+    bool ordered_relay;
+    uint32_t pipeline_depth;
+    bool parallel_block_decode;
+    bool proof_of_work_precheck;
+    uint32_t payload_cache_capacity;
+    bool retain_wire_payloads;
+    uint32_t connection_slab_size;
+    uint32_t memory_budget_megabytes;
+    uint32_t memory_payload_megabytes;
+    uint32_t memory_outbound_megabytes;
+    uint32_t memory_relay_megabytes;
     bool validate_checksum;
     uint32_t identifier;
     uint16_t inbound_port;
@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_SNAPSHOT_RESUBSCRIBER_HPP
+#define LIBBITCOIN_NETWORK_SNAPSHOT_RESUBSCRIBER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/unique_function.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A resubscriber whose subscription list is copy-on-write. Invocation
+/// walks an immutable snapshot of the list, so handlers that resubscribe
+/// (return true) cost no list update, lock or handler copy. The list is
+/// only rewritten on subscribe, on expiry of a handler and on stop.
+/// Handlers of one instance are not invoked concurrently, and a handler that
+/// expires is not invoked again. Subscription does not wait on invocation.
+/// Thread safe.
+template <typename... Args>
+class snapshot_resubscriber
+  : public std::enable_shared_from_this<snapshot_resubscriber<Args...>>,
+    noncopyable
+{
+public:
+    typedef unique_function<bool(Args...)> handler;
+    typedef std::shared_ptr<snapshot_resubscriber<Args...>> ptr;
+
+    /// Construct an instance, the class name is used for dispatch.
+    snapshot_resubscriber(threadpool& pool, const std::string& class_name)
+      : stopped_(true),
+        readers_(0),
+        retiring_(false),
+        current_(std::make_shared<const list>()),
+        subscriptions_(current_.get()),
+        dispatch_(pool, class_name)
+    {
+    }
+
+    /// Enable new subscriptions.
+    void start()
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(subscribe_mutex_);
+
+        stopped_ = false;
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    /// Prevent new subscriptions, those pending are released on invoke.
+    void stop()
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(subscribe_mutex_);
+
+        stopped_ = true;
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    /// Subscribe, or invoke the handler with the stop arguments if stopped.
+    void subscribe(handler&& notify, Args... stopped_args)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        subscribe_mutex_.lock();
+
+        if (stopped_)
+        {
+            subscribe_mutex_.unlock();
+            //-----------------------------------------------------------------
+            notify(stopped_args...);
+            return;
+        }
+
+        const auto updated = std::make_shared<list>(*current_);
+        updated->push_back(std::make_shared<const handler>(
+            std::move(notify)));
+        publish(updated);
+
+        subscribe_mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    /// Invoke all handlers sequentially on this thread (blocking).
+    void invoke(Args... args)
+    {
+        do_invoke(args...);
+    }
+
+    /// Invoke all handlers sequentially on the dispatcher (non-blocking).
+    void relay(Args... args)
+    {
+        // This enqueues work while maintaining order.
+        dispatch_.ordered(&snapshot_resubscriber::do_invoke,
+            this->shared_from_this(), args...);
+    }
+
+private:
+    typedef std::shared_ptr<const handler> handler_ptr;
+    typedef std::vector<handler_ptr> list;
+    typedef std::shared_ptr<const list> list_ptr;
+
+    // Protocols rely on one invocation at a time, so invocations of one
+    // instance are serialized. The reader announces itself before loading
+    // the list pointer, so a writer that observes no reader after publishing
+    // a list knows that no invocation holds a retired list. Subscription
+    // thereby avoids the atomic shared_ptr functions, which lock a shared
+    // mutex pool, and never waits on the handlers.
+    void do_invoke(Args... args)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section (prevent concurrent handler execution)
+        unique_lock invoke_lock(invoke_mutex_);
+
+        readers_.fetch_add(1);
+
+        // Subscriptions made by handlers are invoked on the next round.
+        const auto snapshot = subscriptions_.load();
+        std::vector<const handler*> expired;
+
+        for (const auto& notify: *snapshot)
+            if (!(*notify)(args...))
+                expired.push_back(notify.get());
+
+        if (stopped_ || !expired.empty())
+            remove(expired);
+
+        // The last reader out releases lists retired while it was reading.
+        if (readers_.fetch_sub(1) == 1 && retiring_.load())
+        {
+            ///////////////////////////////////////////////////////////////////
+            // Critical Section
+            unique_lock lock(subscribe_mutex_);
+
+            reclaim();
+            ///////////////////////////////////////////////////////////////////
+        }
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    // All handlers are released once stopped, as with a stopped resubscribe.
+    void remove(const std::vector<const handler*>& expired)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        subscribe_mutex_.lock();
+
+        const auto updated = std::make_shared<list>();
+
+        if (!stopped_)
+        {
+            updated->reserve(current_->size());
+
+            for (const auto& notify: *current_)
+                if (std::find(expired.begin(), expired.end(), notify.get()) ==
+                    expired.end())
+                    updated->push_back(notify);
+        }
+
+        publish(updated);
+
+        subscribe_mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    // The replaced list is retired until no invocation can be reading it.
+    // This must be called under subscribe_mutex_.
+    void publish(list_ptr updated)
+    {
+        retired_.push_back(std::move(current_));
+        current_ = std::move(updated);
+        subscriptions_.store(current_.get());
+        retiring_.store(true);
+        reclaim();
+    }
+
+    // This must be called under subscribe_mutex_.
+    void reclaim()
+    {
+        if (readers_.load() != 0)
+            return;
+
+        retired_.clear();
+        retiring_.store(false);
+    }
+
+    std::atomic<bool> stopped_;
+    std::atomic<size_t> readers_;
+    std::atomic<bool> retiring_;
+
+    // These are protected by subscribe_mutex_.
+    list_ptr current_;
+    std::vector<list_ptr> retired_;
+
+    std::atomic<const list*> subscriptions_;
+    dispatcher dispatch_;
+    mutable upgrade_mutex invoke_mutex_;
+    mutable upgrade_mutex subscribe_mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
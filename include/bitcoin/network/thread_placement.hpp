@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_THREAD_PLACEMENT_HPP
+#define LIBBITCOIN_NETWORK_THREAD_PLACEMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Binds the threads of a pool to processor sets, optionally one NUMA node
+/// per thread (round robin). This keeps threads from migrating across nodes.
+/// It does not place channels on nodes: the pool shares one io_service, so
+/// any thread, on any node, may complete the I/O of a channel.
+class BCT_API thread_placement
+  : noncopyable
+{
+public:
+    typedef std::vector<uint32_t> processors;
+
+    /// Parse a kernel cpu list such as "0-3,8,10-11", empty if invalid.
+    static processors parse(const std::string& list);
+
+    /// The processors of each NUMA node, empty if not discoverable.
+    static std::vector<processors> numa_nodes();
+
+    /// Bind the calling thread to the processors, false if unsupported.
+    static bool bind(const processors& cpus);
+
+    /// True if the calling thread has been placed by apply or place.
+    static bool placed();
+
+    /**
+     * Construct a placement plan.
+     * @param[in]  allowed  The processors to use, empty for all.
+     * @param[in]  numa     Confine each thread to the processors of one node.
+     */
+    thread_placement(const processors& allowed, bool numa);
+
+    /// True if the plan binds no threads.
+    bool empty() const;
+
+    /// The processors assigned to the thread of the given ordinal.
+    const processors& assignment(size_t ordinal) const;
+
+    /// Bind each of the pool's threads, blocking until all are bound.
+    /// The pool must have exactly the given number of idle threads, false
+    /// if it has fewer or they are not all bound within a second. Threads
+    /// are assigned from the given ordinal, so that pools sharing a plan
+    /// are not placed on the same processors.
+    bool apply(threadpool& pool, size_t threads, size_t first=0) const;
+
+    /// Bind the one pool thread not yet placed, such as a thread spawned
+    /// after apply, as the thread of the given ordinal. Does not block, but
+    /// the pool's other threads are held until the new thread is bound.
+    void place(threadpool& pool, size_t ordinal) const;
+
+private:
+    std::vector<processors> sets_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_THREAD_SCALER_HPP
+#define LIBBITCOIN_NETWORK_THREAD_SCALER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
+#include <bitcoin/network/thread_placement.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Grows and shrinks the active threads of a pool within bounds, driven by
+/// the dispatch queue depth and the measured pool scheduling lag.
+/// Threads are added by spawning (or waking a parked thread) and removed by
+/// parking them, since pool threads cannot be retired individually.
+/// Spawned threads are bound by the placement as the next pool ordinal,
+/// counted from the ordinal of the pool's first thread.
+class BCT_API thread_scaler
+  : noncopyable
+{
+public:
+    /// Construct an instance, adaptive only if maximum exceeds minimum.
+    thread_scaler(threadpool& pool, timer_wheel& timers,
+        priority_dispatcher& dispatch, const thread_placement& placement,
+        size_t first, size_t minimum, size_t maximum,
+        const asio::duration& period=asio::seconds(1));
+
+    /// Begin sampling, the pool must have minimum threads spawned.
+    void start();
+
+    /// Stop sampling and release all parked threads (before pool join).
+    void stop();
+
+    /// The number of active (unparked) pool threads.
+    size_t size() const;
+
+    /// The number of times the active thread count has changed.
+    size_t resizes() const;
+
+private:
+    void sample(const code& ec);
+    void probe();
+    void grow();
+    void shrink();
+    void park();
+
+    threadpool& pool_;
+    priority_dispatcher& dispatch_;
+    const thread_placement& placement_;
+    const size_t first_;
+    const size_t minimum_;
+    const size_t maximum_;
+    timer_wheel::timer timer_;
+
+    // These are thread safe.
+    std::atomic<size_t> active_;
+    std::atomic<size_t> resizes_;
+    std::atomic<bool> probing_;
+    std::atomic<int64_t> probe_posted_;
+    std::atomic<int64_t> lag_;
+
+    // These are only accessed from the (sequential) sample handler.
+    size_t busy_samples_;
+    size_t idle_samples_;
+
+    // These are protected by mutex.
+    bool stopped_;
+    size_t parked_;
+    size_t wakes_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
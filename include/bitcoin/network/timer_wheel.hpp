@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TIMER_WHEEL_HPP
+#define LIBBITCOIN_NETWORK_TIMER_WHEEL_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Hierarchical timing wheel shared by all channel and protocol timers.
+/// A single deadline ticks the wheel, timer start/stop is O(1), thread safe.
+class BCT_API timer_wheel
+  : noncopyable
+{
+private:
+    class shard;
+    typedef std::shared_ptr<shard> shard_ptr;
+
+public:
+    typedef std::function<void(const code&)> handler;
+
+    /// A deadline replacement registered with a shard of the wheel.
+    /// The handler is invoked with success on expiration only, not on stop.
+    class BCT_API timer
+      : noncopyable
+    {
+    public:
+        typedef std::shared_ptr<timer> ptr;
+
+        /// Construct a timer on the next shard of the wheel.
+        timer(timer_wheel& wheel, const asio::duration& duration);
+
+        /// Unregister the timer, the handler is not invoked.
+        ~timer();
+
+        /// Start or restart the timer, replacing any pending handler.
+        void start(handler handle);
+
+        /// Start or restart the timer with a new duration.
+        void start(handler handle, const asio::duration& duration);
+
+        /// Cancel the timer, the pending handler is released uninvoked.
+        void stop();
+
+    private:
+        friend class timer_wheel;
+        friend class shard;
+
+        const shard_ptr shard_;
+        asio::duration duration_;
+
+        // These are protected by the shard mutex.
+        timer** previous_;
+        timer* next_;
+        uint64_t expiry_;
+        bool linked_;
+        handler handler_;
+    };
+
+    /// Construct a wheel with the given tick resolution and shard count.
+    timer_wheel(threadpool& pool, const asio::duration& resolution,
+        size_t shards);
+
+    /// Begin ticking the wheel.
+    void start();
+
+    /// Stop ticking the wheel, pending timers are not invoked.
+    void stop();
+
+    /// Advance the wheel through the given tick, invoking expired handlers on
+    /// the calling thread. The ticker does this while started, otherwise the
+    /// caller may drive the wheel from its own clock, one caller at a time.
+    void advance(uint64_t tick);
+
+    /// The coarse clock of the wheel, in ticks since start (relaxed).
+    uint64_t now() const;
+
+    /// The wheel tick period.
+    const asio::duration& resolution() const;
+
+private:
+    static const size_t slot_bits = 6;
+    static const size_t slots = 1u << slot_bits;
+    static const size_t levels = 4;
+
+    typedef std::array<timer*, slots> level;
+    typedef std::vector<handler> handlers;
+
+    /// One independently locked set of wheel levels.
+    class shard
+    {
+    public:
+        shard(const asio::duration& resolution);
+
+        uint64_t to_ticks(const asio::duration& duration) const;
+        void schedule(timer& instance, const asio::duration& duration,
+            handler&& handle, handler& out_replaced);
+        void cancel(timer& instance, handler& out_released);
+        uint64_t advance(uint64_t target);
+        void expire(uint64_t tick, handlers& out_expired);
+
+    private:
+        void link(timer& instance);
+        void unlink(timer& instance);
+        void cascade(size_t depth, size_t index);
+
+        const asio::duration resolution_;
+
+        // These are protected by mutex.
+        uint64_t current_;
+        std::array<level, levels> levels_;
+        mutable shared_mutex mutex_;
+    };
+
+    shard_ptr next_shard();
+    void tick();
+    void handle_tick(const code& ec);
+
+    const asio::duration resolution_;
+    std::vector<shard_ptr> shards_;
+    std::atomic<size_t> next_;
+    std::atomic<uint64_t> now_;
+    std::atomic<bool> stopped_;
+
+    // Written by start while a tick handler of a prior start may read it.
+    std::atomic<asio::time_point> epoch_;
+
+    // These are only accessed from the (sequential) advance.
+    handlers expired_;
+    deadline::ptr ticker_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
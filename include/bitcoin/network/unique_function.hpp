@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_UNIQUE_FUNCTION_HPP
+#define LIBBITCOIN_NETWORK_UNIQUE_FUNCTION_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The inline capacity of a unique_function, sized for a bound member
+/// function or lambda holding a few shared pointers and arguments.
+static const size_t unique_function_size = 128;
+
+template <typename Signature, size_t Size=unique_function_size>
+class unique_function;
+
+/// A move-only replacement for std::function. Callables that fit the inline
+/// buffer and are nothrow movable are stored without heap allocation, others
+/// are allocated. Invocation of an empty instance is undefined.
+template <typename Result, typename... Args, size_t Size>
+class unique_function<Result(Args...), Size>
+{
+public:
+    unique_function()
+      : table_(nullptr)
+    {
+    }
+
+    unique_function(std::nullptr_t)
+      : table_(nullptr)
+    {
+    }
+
+    template <typename Function, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<Function>::type,
+            unique_function>::value>::type>
+    unique_function(Function&& function)
+      : table_(nullptr)
+    {
+        typedef typename std::decay<Function>::type callable;
+        typedef typename std::conditional<fits<callable>(),
+            local<callable>, remote<callable>>::type storage;
+
+        storage::construct(&buffer_, std::forward<Function>(function));
+        table_ = &storage::table;
+    }
+
+    unique_function(unique_function&& other) noexcept
+      : table_(other.table_)
+    {
+        if (table_ != nullptr)
+            table_->move(&buffer_, &other.buffer_);
+
+        other.table_ = nullptr;
+    }
+
+    unique_function& operator=(unique_function&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            table_ = other.table_;
+
+            if (table_ != nullptr)
+                table_->move(&buffer_, &other.buffer_);
+
+            other.table_ = nullptr;
+        }
+
+        return *this;
+    }
+
+    unique_function& operator=(std::nullptr_t)
+    {
+        clear();
+        return *this;
+    }
+
+    ~unique_function()
+    {
+        clear();
+    }
+
+    unique_function(const unique_function&) = delete;
+    unique_function& operator=(const unique_function&) = delete;
+
+    explicit operator bool() const
+    {
+        return table_ != nullptr;
+    }
+
+    /// True if the callable is stored in the inline buffer.
+    bool inlined() const
+    {
+        return table_ != nullptr && table_->inlined;
+    }
+
+    Result operator()(Args... args) const
+    {
+        BITCOIN_ASSERT(table_ != nullptr);
+        return table_->invoke(&buffer_, std::forward<Args>(args)...);
+    }
+
+private:
+    typedef typename std::aligned_storage<Size>::type buffer;
+
+    struct vtable
+    {
+        Result(*invoke)(buffer*, Args&&...);
+        void(*move)(buffer*, buffer*);
+        void(*destroy)(buffer*);
+        bool inlined;
+    };
+
+    template <typename Callable>
+    static constexpr bool fits()
+    {
+        return sizeof(Callable) <= Size &&
+            alignof(buffer) % alignof(Callable) == 0 &&
+            std::is_nothrow_move_constructible<Callable>::value;
+    }
+
+    // The callable is constructed in the buffer.
+    template <typename Callable>
+    struct local
+    {
+        template <typename Function>
+        static void construct(buffer* target, Function&& function)
+        {
+            new (target) Callable(std::forward<Function>(function));
+        }
+
+        static Callable& get(buffer* source)
+        {
+            return *reinterpret_cast<Callable*>(source);
+        }
+
+        static Result invoke(buffer* source, Args&&... args)
+        {
+            return get(source)(std::forward<Args>(args)...);
+        }
+
+        static void move(buffer* target, buffer* source)
+        {
+            new (target) Callable(std::move(get(source)));
+            get(source).~Callable();
+        }
+
+        static void destroy(buffer* source)
+        {
+            get(source).~Callable();
+        }
+
+        static const vtable table;
+    };
+
+    // The buffer holds a pointer to the allocated callable.
+    template <typename Callable>
+    struct remote
+    {
+        template <typename Function>
+        static void construct(buffer* target, Function&& function)
+        {
+            new (target) Callable*(new Callable(
+                std::forward<Function>(function)));
+        }
+
+        static Callable*& get(buffer* source)
+        {
+            return *reinterpret_cast<Callable**>(source);
+        }
+
+        static Result invoke(buffer* source, Args&&... args)
+        {
+            return (*get(source))(std::forward<Args>(args)...);
+        }
+
+        static void move(buffer* target, buffer* source)
+        {
+            new (target) Callable*(get(source));
+        }
+
+        static void destroy(buffer* source)
+        {
+            delete get(source);
+        }
+
+        static const vtable table;
+    };
+
+    void clear()
+    {
+        if (table_ != nullptr)
+            table_->destroy(&buffer_);
+
+        table_ = nullptr;
+    }
+
+    const vtable* table_;
+    mutable buffer buffer_;
+};
+
+template <typename Result, typename... Args, size_t Size>
+template <typename Callable>
+const typename unique_function<Result(Args...), Size>::vtable
+    unique_function<Result(Args...), Size>::local<Callable>::table =
+{
+    &local<Callable>::invoke,
+    &local<Callable>::move,
+    &local<Callable>::destroy,
+    true
+};
+
+template <typename Result, typename... Args, size_t Size>
+template <typename Callable>
+const typename unique_function<Result(Args...), Size>::vtable
+    unique_function<Result(Args...), Size>::remote<Callable>::table =
+{
+    &remote<Callable>::invoke,
+    &remote<Callable>::move,
+    &remote<Callable>::destroy,
+    false
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
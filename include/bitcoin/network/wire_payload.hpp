@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_WIRE_PAYLOAD_HPP
+#define LIBBITCOIN_NETWORK_WIRE_PAYLOAD_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The wire payload of a received message, retained by its decoded instance
+/// so that the message can be forwarded to peers without serialization.
+/// The payload is owned by the control block of the message pointer, so it
+/// is released with the message. Thread safe once the message is published.
+class BCT_API wire_payload
+  : noncopyable
+{
+public:
+    typedef std::shared_ptr<wire_payload> ptr;
+    typedef std::shared_ptr<const data_chunk> payload_ptr;
+
+    /// Allocate a message instance that retains the wire payload.
+    template <class Message>
+    static std::shared_ptr<Message> allocate(ptr wire)
+    {
+        return std::shared_ptr<Message>(new Message, deleter<Message>{ wire });
+    }
+
+    /// The wire payload retained by a message instance, or nullptr.
+    template <class Message>
+    static ptr find(const std::shared_ptr<const Message>& message)
+    {
+        const auto retainer = std::get_deleter<deleter<Message>>(message);
+        return retainer == nullptr ? nullptr : retainer->wire;
+    }
+
+    /// Construct a payload record, not portable until set.
+    wire_payload(payload_ptr payload);
+
+    /// The payload bytes.
+    const data_chunk& payload() const;
+
+    /// The payload checksum, computed once (the peer value is not trusted).
+    uint32_t checksum() const;
+
+    /// True if the payload encodes identically for any peer.
+    bool portable() const;
+
+    /// Set portability, only before the message is published.
+    void set_portable(bool value);
+
+private:
+    template <class Message>
+    struct deleter
+    {
+        ptr wire;
+
+        void operator()(Message* message) const
+        {
+            delete message;
+        }
+    };
+
+    const payload_ptr payload_;
+    bool portable_;
+
+    // These are guarded by the once flag.
+    mutable uint32_t checksum_;
+    mutable std::once_flag once_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
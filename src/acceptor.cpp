@@ -24,8 +24,10 @@
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -36,9 +38,17 @@ using namespace std::placeholders;
 
 static const auto reuse_address = asio::acceptor::reuse_address(true);
 
-acceptor::acceptor(threadpool& pool, const settings& settings)
+acceptor::acceptor(threadpool& pool, timer_wheel& timers,
+    priority_dispatcher& dispatch, payload_cache& payloads,
+    connection_slab& slab, memory_governor& governor,
+    const settings& settings)
   : stopped_(true),
     pool_(pool),
+    timers_(timers),
+    priority_dispatch_(dispatch),
+    payloads_(payloads),
+    slab_(slab),
+    governor_(governor),
     settings_(settings),
     dispatch_(pool, NAME),
     acceptor_(pool_.service()),
@@ -133,7 +143,10 @@ void acceptor::accept(accept_handler handler)
         return;
     }
 
-    const auto socket = std::make_shared<bc::socket>(pool_);
+    // The socket keeps the slab entry in use until the channel is created.
+    const connection_slab::lease lease(slab_);
+    const auto allocator = lease.get_allocator();
+    const auto socket = std::allocate_shared<bc::socket>(allocator, pool_);
 
     mutex_.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -144,7 +157,7 @@ void acceptor::accept(accept_handler handler)
     // to the thread of the socket, then this is unnecessary.
     acceptor_.async_accept(socket->get(),
         std::bind(&acceptor::handle_accept,
-            shared_from_this(), _1, socket, handler));
+            shared_from_this(), _1, socket, allocator, handler));
 
     mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
@@ -152,7 +165,7 @@ void acceptor::accept(accept_handler handler)
 
 // private:
 void acceptor::handle_accept(const boost_code& ec, socket::ptr socket,
-    accept_handler handler)
+    const connection_slab::byte_allocator& allocator, accept_handler handler)
 {
     if (ec)
     {
@@ -161,7 +174,9 @@ void acceptor::handle_accept(const boost_code& ec, socket::ptr socket,
     }
 
     // Ensure that channel is not passed as an r-value.
-    const auto created = std::make_shared<channel>(pool_, socket, settings_);
+    const auto created = std::allocate_shared<channel>(allocator, pool_,
+        socket, timers_, priority_dispatch_, payloads_, allocator, governor_,
+        settings_);
     handler(error::success, created);
 }
 
@@ -0,0 +1,520 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/block_decoder.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <boost/iostreams/stream.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/header_hasher.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#ifdef BITPRIM_CURRENCY_BCH
+static const bool witness = false;
+#else
+static const bool witness = true;
+#endif
+
+static const size_t header_size = header_hasher::header_size;
+
+// A headers message header is followed by a zero transaction count byte.
+static const size_t listed_header_size = header_size + 1;
+
+// The little endian compact target follows version, hashes and timestamp.
+static const size_t bits_offset = 72;
+
+// The smallest serialized transaction (no inputs or outputs).
+static const size_t minimum_transaction_size = 10;
+
+// Chunks are small enough to balance load but large enough to amortize.
+static const size_t chunks_per_thread = 4;
+static const size_t minimum_chunk_transactions = 16;
+
+// A stream source over a range of the payload, avoiding a copy per slice.
+class range_source
+{
+public:
+    typedef char char_type;
+    typedef boost::iostreams::source_tag category;
+
+    range_source(const uint8_t* begin, const uint8_t* end)
+      : position_(begin), end_(end)
+    {
+    }
+
+    std::streamsize read(char_type* buffer, std::streamsize size)
+    {
+        const auto count = std::min<std::streamsize>(size, end_ - position_);
+
+        if (count <= 0)
+            return -1;
+
+        std::copy(position_, position_ + count,
+            reinterpret_cast<uint8_t*>(buffer));
+        position_ += count;
+        return count;
+    }
+
+private:
+    const uint8_t* position_;
+    const uint8_t* end_;
+};
+
+typedef boost::iostreams::stream<range_source> range_stream;
+
+static bool exhausted(std::istream& stream)
+{
+    return stream.peek() == std::istream::traits_type::eof();
+}
+
+// Scanning.
+// ----------------------------------------------------------------------------
+
+static bool skip(const data_chunk& payload, size_t& offset, uint64_t bytes)
+{
+    if (payload.size() - offset < bytes)
+        return false;
+
+    offset += static_cast<size_t>(bytes);
+    return true;
+}
+
+static bool read_size(const data_chunk& payload, size_t& offset,
+    uint64_t& out)
+{
+    if (offset >= payload.size())
+        return false;
+
+    const auto prefix = payload[offset++];
+    const size_t width = prefix == 0xff ? 8 : prefix == 0xfe ? 4 :
+        prefix == 0xfd ? 2 : 0;
+
+    if (width == 0)
+    {
+        out = prefix;
+        return true;
+    }
+
+    if (payload.size() - offset < width)
+        return false;
+
+    out = 0;
+    for (size_t byte = 0; byte < width; ++byte)
+        out |= uint64_t(payload[offset + byte]) << (8 * byte);
+
+    offset += width;
+    return true;
+}
+
+static bool skip_sized(const data_chunk& payload, size_t& offset)
+{
+    uint64_t size;
+    return read_size(payload, offset, size) && skip(payload, offset, size);
+}
+
+// Every element consumes at least one byte, so malformed counts fail fast.
+static bool scan_transaction(const data_chunk& payload, size_t& offset)
+{
+    // version
+    if (!skip(payload, offset, 4))
+        return false;
+
+    // marker and flag
+    const auto segregated = witness && payload.size() - offset >= 2 &&
+        payload[offset] == 0x00 && payload[offset + 1] == 0x01;
+
+    if (segregated)
+        offset += 2;
+
+    uint64_t inputs;
+    if (!read_size(payload, offset, inputs))
+        return false;
+
+    // previous output, script, sequence
+    for (uint64_t input = 0; input < inputs; ++input)
+        if (!skip(payload, offset, 36) || !skip_sized(payload, offset) ||
+            !skip(payload, offset, 4))
+            return false;
+
+    uint64_t outputs;
+    if (!read_size(payload, offset, outputs))
+        return false;
+
+    // value, script
+    for (uint64_t output = 0; output < outputs; ++output)
+        if (!skip(payload, offset, 8) || !skip_sized(payload, offset))
+            return false;
+
+    // witness stack per input
+    for (uint64_t input = 0; segregated && input < inputs; ++input)
+    {
+        uint64_t items;
+        if (!read_size(payload, offset, items))
+            return false;
+
+        for (uint64_t item = 0; item < items; ++item)
+            if (!skip_sized(payload, offset))
+                return false;
+    }
+
+    // locktime
+    return skip(payload, offset, 4);
+}
+
+bool block_decoder::scan(const data_chunk& payload, size_t offset,
+    size_t count, offsets& out_ends)
+{
+    out_ends.clear();
+
+    if (offset > payload.size() ||
+        count > (payload.size() - offset) / minimum_transaction_size)
+        return false;
+
+    out_ends.reserve(count);
+
+    for (size_t transaction = 0; transaction < count; ++transaction)
+    {
+        if (!scan_transaction(payload, offset))
+            return false;
+
+        out_ends.push_back(offset);
+    }
+
+    return true;
+}
+
+// Proof of work.
+// ----------------------------------------------------------------------------
+
+// The header is not bound to a chain, so only its own target is enforced.
+static bool is_valid_work(const uint8_t* header, const hash_digest& hash)
+{
+    uint32_t bits = 0;
+    for (size_t byte = 0; byte < sizeof(bits); ++byte)
+        bits |= uint32_t(header[bits_offset + byte]) << (8 * byte);
+
+    const chain::compact compact_bits(bits);
+
+    if (compact_bits.is_overflowed())
+        return false;
+
+    const uint256_t target(compact_bits);
+    return target != 0 && to_uint256(hash) <= target;
+}
+
+bool block_decoder::check_work(message::message_type type,
+    const data_chunk& payload)
+{
+    if (type == message::message_type::block)
+    {
+        if (payload.size() < header_size)
+            return false;
+
+        hash_digest hash;
+        header_hasher::hash(payload.data(), header_size, 1, &hash);
+        return is_valid_work(payload.data(), hash);
+    }
+
+    if (type != message::message_type::headers)
+        return true;
+
+    uint64_t count;
+    size_t offset = 0;
+
+    // Trailing bytes are left to the decode.
+    if (!read_size(payload, offset, count) ||
+        count > (payload.size() - offset) / listed_header_size)
+        return false;
+
+    const auto headers = payload.data() + offset;
+    std::vector<hash_digest> hashes(static_cast<size_t>(count));
+    header_hasher::hash(headers, listed_header_size, hashes.size(),
+        hashes.data());
+
+    for (size_t index = 0; index < hashes.size(); ++index)
+        if (!is_valid_work(headers + index * listed_header_size,
+            hashes[index]))
+            return false;
+
+    return true;
+}
+
+// Parsing.
+// ----------------------------------------------------------------------------
+
+// Shared with pool threads, which may start after the decode has returned.
+// Caller state is only referenced by a thread holding an unparsed chunk.
+struct parse_state
+{
+    const uint8_t* data;
+    size_t first;
+    const block_decoder::offsets* ends;
+    chain::transaction::list* transactions;
+    size_t chunk;
+    size_t chunks;
+
+    std::atomic<size_t> next;
+    std::atomic<bool> valid;
+
+    // These are protected by mutex.
+    size_t completed;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+// Witness is excluded from the txid, so only hash unsegregated bytes.
+static bool is_segregated(const uint8_t* begin, const uint8_t* end)
+{
+    return witness && end - begin > 5 && begin[4] == 0x00 && begin[5] == 0x01;
+}
+
+static void parse_chunk(parse_state& state, size_t index)
+{
+    auto& transactions = *state.transactions;
+    const auto& ends = *state.ends;
+    const auto first = index * state.chunk;
+    const auto last = std::min(first + state.chunk, transactions.size());
+    auto begin = state.data + (first == 0 ? state.first : ends[first - 1]);
+
+    range_source source(begin, state.data + ends[last - 1]);
+    range_stream stream(source);
+
+    for (auto position = first; position < last; ++position)
+    {
+        chain::transaction transaction;
+        const auto end = state.data + ends[position];
+
+        if (!transaction.from_data(stream, true, witness))
+        {
+            state.valid = false;
+            return;
+        }
+
+        if (is_segregated(begin, end))
+            transactions[position] = std::move(transaction);
+        else
+            transactions[position] = chain::transaction(
+                std::move(transaction), bitcoin_hash(data_slice(begin, end)));
+
+        begin = end;
+    }
+
+    // The parse must agree with the scanned boundaries.
+    if (!exhausted(stream))
+        state.valid = false;
+}
+
+static void parse_chunks(std::shared_ptr<parse_state> state)
+{
+    for (auto index = state->next++; index < state->chunks;
+        index = state->next++)
+    {
+        if (state->valid)
+            parse_chunk(*state, index);
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        if (++state->completed == state->chunks)
+            state->condition.notify_all();
+        ///////////////////////////////////////////////////////////////////////
+    }
+}
+
+block_decoder::block_decoder(threadpool& pool, size_t minimum)
+  : pool_(pool),
+    minimum_(minimum)
+{
+}
+
+bool block_decoder::segregated(message::message_type type,
+    const data_chunk& payload)
+{
+    if (!witness)
+        return false;
+
+    const auto begin = payload.data();
+
+    if (type == message::message_type::transaction)
+        return is_segregated(begin, begin + payload.size());
+
+    if (type != message::message_type::block)
+        return false;
+
+    uint64_t count;
+    offsets ends;
+    auto offset = header_size;
+
+    // An unscannable payload is treated as segregated, it is not reused.
+    if (!read_size(payload, offset, count) ||
+        !scan(payload, offset, static_cast<size_t>(count), ends))
+        return true;
+
+    for (const auto end: ends)
+    {
+        if (is_segregated(begin + offset, begin + end))
+            return true;
+
+        offset = end;
+    }
+
+    return false;
+}
+
+bool block_decoder::decode(uint32_t, const data_chunk& payload,
+    message::block& out) const
+{
+    if (payload.size() < header_size)
+        return false;
+
+    chain::header header;
+    range_source source(payload.data(), payload.data() + header_size);
+    range_stream stream(source);
+
+    if (!header.from_data(stream))
+        return false;
+
+    uint64_t count;
+    offsets ends;
+    auto offset = header_size;
+
+    if (!read_size(payload, offset, count) ||
+        !scan(payload, offset, static_cast<size_t>(count), ends) ||
+        (ends.empty() ? offset : ends.back()) != payload.size())
+        return false;
+
+    // Transactions are parsed in place into the preallocated list.
+    chain::transaction::list transactions(ends.size());
+
+    if (!decode_transactions(payload, offset, ends, transactions))
+        return false;
+
+    const auto begin = payload.data();
+    out = message::block(
+        chain::header(std::move(header),
+            bitcoin_hash(data_slice(begin, begin + header_size))),
+        std::move(transactions));
+
+    return true;
+}
+
+bool block_decoder::decode(uint32_t version, const data_chunk& payload,
+    message::transaction& out) const
+{
+    const auto begin = payload.data();
+    const auto end = begin + payload.size();
+    range_source source(begin, end);
+    range_stream stream(source);
+
+    if (!out.from_data(version, stream) || !exhausted(stream))
+        return false;
+
+    if (!is_segregated(begin, end))
+        out = message::transaction(chain::transaction(std::move(out),
+            bitcoin_hash(data_slice(begin, end))));
+
+    return true;
+}
+
+bool block_decoder::decode(uint32_t version, const data_chunk& payload,
+    message::headers& out) const
+{
+    range_source source(payload.data(), payload.data() + payload.size());
+    range_stream stream(source);
+
+    if (!out.from_data(version, stream) || !exhausted(stream))
+        return false;
+
+    auto& elements = out.elements();
+    uint64_t count;
+    size_t offset = 0;
+
+    // The parse guarantees the layout, this only locates the first header.
+    if (elements.empty() || !read_size(payload, offset, count) ||
+        count != elements.size() ||
+        payload.size() - offset != elements.size() * listed_header_size)
+        return true;
+
+    // All headers are hashed in one batch, in place over the payload.
+    std::vector<hash_digest> hashes(elements.size());
+    header_hasher::hash(payload.data() + offset, listed_header_size,
+        elements.size(), hashes.data());
+
+    for (size_t index = 0; index < elements.size(); ++index)
+        elements[index] = message::header(chain::header(
+            std::move(elements[index]), std::move(hashes[index])));
+
+    return true;
+}
+
+bool block_decoder::decode_transactions(const data_chunk& payload,
+    size_t offset, const offsets& ends, chain::transaction::list& out) const
+{
+    if (out.empty())
+        return true;
+
+    // Smaller payloads are parsed entirely on the calling thread.
+    const auto parallel = payload.size() >= minimum_;
+    const auto threads = parallel ? std::max(pool_.size(), size_t(1)) : 1;
+    const auto target = threads * chunks_per_thread;
+    const auto chunk = std::max(minimum_chunk_transactions,
+        (out.size() + target - 1) / target);
+    const auto chunks = (out.size() + chunk - 1) / chunk;
+
+    const auto state = std::make_shared<parse_state>();
+    state->data = payload.data();
+    state->first = offset;
+    state->ends = &ends;
+    state->transactions = &out;
+    state->chunk = chunk;
+    state->chunks = chunks;
+    state->next = 0;
+    state->valid = true;
+    state->completed = 0;
+
+    const auto helpers = std::min(threads, chunks) - 1;
+
+    for (size_t helper = 0; helper < helpers; ++helper)
+        pool_.service().post(std::bind(parse_chunks, state));
+
+    // The caller parses until no chunk remains, then awaits the helpers.
+    parse_chunks(state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state]()
+    {
+        return state->completed == state->chunks;
+    });
+
+    return state->valid;
+}
+
+} // namespace network
+} // namespace libbitcoin
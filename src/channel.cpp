@@ -27,6 +27,7 @@
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -34,19 +35,19 @@ namespace network {
 using namespace bc::message;
 using namespace std::placeholders;
 
-// Factory for deadline timer pointer construction.
-static deadline::ptr alarm(threadpool& pool, const asio::duration& duration)
-{
-    return std::make_shared<deadline>(pool, pseudo_random::duration(duration));
-}
-
-channel::channel(threadpool& pool, socket::ptr socket,
-    const settings& settings)
-  : proxy(pool, socket, settings),
+channel::channel(threadpool& pool, socket::ptr socket, timer_wheel& timers,
+    priority_dispatcher& dispatch, payload_cache& payloads,
+    const connection_slab::byte_allocator& allocator,
+    memory_governor& governor, const settings& settings)
+  : proxy(pool, socket, dispatch, payloads, allocator, governor, settings),
     notify_(false),
     nonce_(0),
-    expiration_(alarm(pool, settings.channel_expiration())),
-    inactivity_(alarm(pool, settings.channel_inactivity())),
+    timers_(timers),
+    inactivity_period_(pseudo_random::duration(settings.channel_inactivity())),
+    last_activity_(timers.now()),
+    expiration_(timers,
+        pseudo_random::duration(settings.channel_expiration())),
+    inactivity_(timers, inactivity_period_),
     CONSTRUCT_TRACK(channel)
 {
 }
@@ -65,8 +66,9 @@ void channel::start(result_handler handler)
 // Don't start the timers until the socket is enabled.
 void channel::do_start(const code& ec, result_handler handler)
 {
+    last_activity_.store(timers_.now(), std::memory_order_relaxed);
     start_expiration();
-    start_inactivity();
+    start_inactivity(inactivity_period_);
     handler(error::success);
 }
 
@@ -111,13 +113,14 @@ void channel::set_peer_version(version_const_ptr value)
 // It is possible that this may be called multiple times.
 void channel::handle_stopping()
 {
-    expiration_->stop();
-    inactivity_->stop();
+    expiration_.stop();
+    inactivity_.stop();
 }
 
+// This is invoked for every message, so it must not touch the timer.
 void channel::signal_activity()
 {
-    start_inactivity();
+    last_activity_.store(timers_.now(), std::memory_order_relaxed);
 }
 
 bool channel::stopped(const code& ec) const
@@ -134,7 +137,7 @@ void channel::start_expiration()
     if (proxy::stopped())
         return;
 
-    expiration_->start(
+    expiration_.start(
         std::bind(&channel::handle_expiration,
             shared_from_base<channel>(), _1));
 }
@@ -150,21 +153,35 @@ void channel::handle_expiration(const code& ec)
     stop(error::channel_timeout);
 }
 
-void channel::start_inactivity()
+void channel::start_inactivity(const asio::duration& timeout)
 {
     if (proxy::stopped())
         return;
 
-    inactivity_->start(
+    inactivity_.start(
         std::bind(&channel::handle_inactivity,
-            shared_from_base<channel>(), _1));
+            shared_from_base<channel>(), _1), timeout);
 }
 
+// The timer fires at most once per period, and is then deferred by the time
+// elapsed since the last message, so activity never re-arms the timer.
 void channel::handle_inactivity(const code& ec)
 {
     if (stopped(ec))
         return;
 
+    const auto last = last_activity_.load(std::memory_order_relaxed);
+    const auto now = timers_.now();
+    const auto ticks = static_cast<asio::duration::rep>(now > last ?
+        now - last : 0);
+    const auto idle = timers_.resolution() * ticks;
+
+    if (idle < inactivity_period_)
+    {
+        start_inactivity(inactivity_period_ - idle);
+        return;
+    }
+
     LOG_DEBUG(LOG_NETWORK)
         << "Channel inactivity timeout [" << authority() << "]";
 
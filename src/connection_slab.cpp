@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/connection_slab.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// Blocks are aligned as by operator new.
+static const size_t block_alignment = alignof(std::max_align_t);
+
+static size_t align(size_t size)
+{
+    return (size + block_alignment - 1) & ~(block_alignment - 1);
+}
+
+connection_slab::connection_slab(size_t entries, size_t entry_size)
+  : entries_(entry_size == 0 ? 0 : entries)
+{
+    if (entries_.empty())
+        return;
+
+    const auto size = align(entry_size);
+    memory_.reset(new uint8_t[entries_.size() * size]);
+    free_.reserve(entries_.size());
+
+    for (size_t index = 0; index < entries_.size(); ++index)
+    {
+        auto& instance = entries_[index];
+        instance.slab_ = this;
+        instance.begin_ = &memory_[index * size];
+        instance.size_ = size;
+        free_.push_back(&instance);
+    }
+}
+
+bool connection_slab::enabled() const
+{
+    return !entries_.empty();
+}
+
+size_t connection_slab::available() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return free_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+connection_slab::entry* connection_slab::acquire()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (free_.empty())
+        return nullptr;
+
+    const auto instance = free_.back();
+    free_.pop_back();
+    return instance;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void connection_slab::release(entry* instance)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    free_.push_back(instance);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Entry.
+// ----------------------------------------------------------------------------
+
+connection_slab::entry::entry()
+  : slab_(nullptr),
+    begin_(nullptr),
+    size_(0),
+    used_(0),
+    references_(0)
+{
+}
+
+// The arena only grows, its blocks are reclaimed together on release.
+void* connection_slab::entry::allocate(size_t size)
+{
+    const auto aligned = align(size);
+    auto offset = used_.load(std::memory_order_relaxed);
+
+    do
+    {
+        if (aligned > size_ || offset > size_ - aligned)
+            return nullptr;
+    } while (!used_.compare_exchange_weak(offset, offset + aligned,
+        std::memory_order_relaxed));
+
+    hold();
+    return begin_ + offset;
+}
+
+bool connection_slab::entry::deallocate(void* block)
+{
+    const auto position = static_cast<uint8_t*>(block);
+
+    if (position < begin_ || position >= begin_ + size_)
+        return false;
+
+    release();
+    return true;
+}
+
+void connection_slab::entry::hold()
+{
+    references_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void connection_slab::entry::release()
+{
+    if (references_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    used_.store(0, std::memory_order_relaxed);
+    slab_->release(this);
+}
+
+// Lease.
+// ----------------------------------------------------------------------------
+
+connection_slab::lease::lease(connection_slab& slab)
+  : entry_(slab.acquire())
+{
+    if (entry_ != nullptr)
+        entry_->hold();
+}
+
+connection_slab::lease::~lease()
+{
+    if (entry_ != nullptr)
+        entry_->release();
+}
+
+connection_slab::byte_allocator connection_slab::lease::get_allocator() const
+{
+    return byte_allocator(entry_);
+}
+
+} // namespace network
+} // namespace libbitcoin
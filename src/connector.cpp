@@ -25,8 +25,10 @@
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -36,9 +38,17 @@ namespace network {
 using namespace bc::config;
 using namespace std::placeholders;
 
-connector::connector(threadpool& pool, const settings& settings)
+connector::connector(threadpool& pool, timer_wheel& timers,
+    priority_dispatcher& dispatch, payload_cache& payloads,
+    connection_slab& slab, memory_governor& governor,
+    const settings& settings)
   : stopped_(false),
     pool_(pool),
+    timers_(timers),
+    priority_dispatch_(dispatch),
+    payloads_(payloads),
+    slab_(slab),
+    governor_(governor),
     settings_(settings),
     dispatch_(pool, NAME),
     resolver_(pool.service()),
@@ -148,7 +158,10 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
         return;
     }
 
-    const auto socket = std::make_shared<bc::socket>(pool_);
+    // The socket keeps the slab entry in use until the channel is created.
+    const connection_slab::lease lease(slab_);
+    const auto allocator = lease.get_allocator();
+    const auto socket = std::allocate_shared<bc::socket>(allocator, pool_);
     timer_ = std::make_shared<deadline>(pool_, settings_.connect_timeout());
 
     // Manage the timer-connect race, returning upon first completion.
@@ -164,7 +177,7 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
     // The bound delegate ensures handler completion before loss of scope.
     async_connect(socket->get(), iterator,
         std::bind(&connector::handle_connect,
-            shared_from_this(), _1, _2, socket, join_handler));
+            shared_from_this(), _1, _2, socket, allocator, join_handler));
 
     mutex_.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
@@ -172,7 +185,8 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
 
 // private:
 void connector::handle_connect(const boost_code& ec, asio::iterator,
-    socket::ptr socket, connect_handler handler)
+    socket::ptr socket, const connection_slab::byte_allocator& allocator,
+    connect_handler handler)
 {
     if (ec)
     {
@@ -181,7 +195,9 @@ void connector::handle_connect(const boost_code& ec, asio::iterator,
     }
 
     // Ensure that channel is not passed as an r-value.
-    const auto created = std::make_shared<channel>(pool_, socket, settings_);
+    const auto created = std::allocate_shared<channel>(allocator, pool_,
+        socket, timers_, priority_dispatch_, payloads_, allocator, governor_,
+        settings_);
     handler(error::success, created);
 }
 
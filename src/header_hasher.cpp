@@ -0,0 +1,575 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/header_hasher.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+    #define HAVE_X86_KERNELS
+    #include <cpuid.h>
+    #include <immintrin.h>
+#endif
+
+namespace libbitcoin {
+namespace network {
+
+// Each header hash is three compressions, two over the 80 header bytes and
+// one over the 32 byte first digest. Trailing blocks are built from words.
+static const uint32_t padding = 0x80000000;
+static const uint32_t header_bits = 80 * 8;
+static const uint32_t digest_bits = 32 * 8;
+
+static const uint32_t initial[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t load_big(const uint8_t* data)
+{
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) |
+        (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+}
+
+static inline void store_big(uint8_t* data, uint32_t value)
+{
+    data[0] = static_cast<uint8_t>(value >> 24);
+    data[1] = static_cast<uint8_t>(value >> 16);
+    data[2] = static_cast<uint8_t>(value >> 8);
+    data[3] = static_cast<uint8_t>(value);
+}
+
+// Build the second header block and the digest block in place.
+static inline void header_tail(uint32_t block[16], const uint8_t* header)
+{
+    for (size_t word = 0; word < 4; ++word)
+        block[word] = load_big(header + 64 + 4 * word);
+
+    block[4] = padding;
+
+    for (size_t word = 5; word < 15; ++word)
+        block[word] = 0;
+
+    block[15] = header_bits;
+}
+
+static inline void digest_block(uint32_t block[16], const uint32_t state[8])
+{
+    for (size_t word = 0; word < 8; ++word)
+        block[word] = state[word];
+
+    block[8] = padding;
+
+    for (size_t word = 9; word < 15; ++word)
+        block[word] = 0;
+
+    block[15] = digest_bits;
+}
+
+// The single buffer driver, over a compression function of message words.
+template <typename Compress>
+static void hash_one(Compress compress, const uint8_t* header,
+    hash_digest& out)
+{
+    uint32_t block[16];
+    uint32_t state[8];
+    uint32_t second[8];
+
+    for (size_t word = 0; word < 16; ++word)
+        block[word] = load_big(header + 4 * word);
+
+    std::copy(initial, initial + 8, state);
+    compress(state, block);
+    header_tail(block, header);
+    compress(state, block);
+
+    digest_block(block, state);
+    std::copy(initial, initial + 8, second);
+    compress(second, block);
+
+    for (size_t word = 0; word < 8; ++word)
+        store_big(out.data() + 4 * word, second[word]);
+}
+
+// Scalar kernel.
+// ----------------------------------------------------------------------------
+
+static inline uint32_t rotate(uint32_t value, uint32_t bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static void compress_scalar(uint32_t state[8], const uint32_t block[16])
+{
+    uint32_t w[64];
+    std::copy(block, block + 16, w);
+
+    for (size_t round = 16; round < 64; ++round)
+    {
+        const auto s0 = rotate(w[round - 15], 7) ^
+            rotate(w[round - 15], 18) ^ (w[round - 15] >> 3);
+        const auto s1 = rotate(w[round - 2], 17) ^
+            rotate(w[round - 2], 19) ^ (w[round - 2] >> 10);
+        w[round] = w[round - 16] + s0 + w[round - 7] + s1;
+    }
+
+    auto a = state[0], b = state[1], c = state[2], d = state[3];
+    auto e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (size_t round = 0; round < 64; ++round)
+    {
+        const auto s1 = rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25);
+        const auto choose = (e & f) ^ (~e & g);
+        const auto t1 = h + s1 + choose + constants[round] + w[round];
+        const auto s0 = rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22);
+        const auto majority = (a & b) ^ (a & c) ^ (b & c);
+        const auto t2 = s0 + majority;
+
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// SHA extensions kernel.
+// ----------------------------------------------------------------------------
+
+#define SHA_NI __attribute__((target("sha,sse4.1,ssse3")))
+
+// Four rounds per group, the schedule for group g + 4 is completed by group
+// g + 3 (msg2) from the partial schedule started by group g + 1 (msg1).
+SHA_NI static void compress_sha_ni(uint32_t state[8], const uint32_t block[16])
+{
+    typedef const __m128i* pointer;
+    __m128i message[4];
+
+    auto swap = _mm_shuffle_epi32(_mm_loadu_si128((pointer)&state[0]), 0xb1);
+    auto state1 = _mm_shuffle_epi32(_mm_loadu_si128((pointer)&state[4]), 0x1b);
+    auto state0 = _mm_alignr_epi8(swap, state1, 8);
+    state1 = _mm_blend_epi16(state1, swap, 0xf0);
+
+    const auto save0 = state0;
+    const auto save1 = state1;
+
+    for (size_t group = 0; group < 16; ++group)
+    {
+        auto& current = message[group % 4];
+
+        if (group < 4)
+            current = _mm_loadu_si128((pointer)&block[4 * group]);
+
+        auto value = _mm_add_epi32(current,
+            _mm_loadu_si128((pointer)&constants[4 * group]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, value);
+
+        if (group >= 3 && group < 15)
+        {
+            auto& next = message[(group + 1) % 4];
+            const auto& previous = message[(group + 3) % 4];
+            next = _mm_add_epi32(next, _mm_alignr_epi8(current, previous, 4));
+            next = _mm_sha256msg2_epu32(next, current);
+        }
+
+        value = _mm_shuffle_epi32(value, 0x0e);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, value);
+
+        if (group >= 1 && group < 13)
+        {
+            auto& previous = message[(group + 3) % 4];
+            previous = _mm_sha256msg1_epu32(previous, current);
+        }
+    }
+
+    state0 = _mm_add_epi32(state0, save0);
+    state1 = _mm_add_epi32(state1, save1);
+
+    swap = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(swap, state1, 0xf0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(state1, swap, 8));
+}
+
+SHA_NI static void hash_sha_ni(const uint8_t* header, hash_digest& out)
+{
+    hash_one(compress_sha_ni, header, out);
+}
+
+#undef SHA_NI
+
+// Multi-buffer kernels.
+// ----------------------------------------------------------------------------
+// Each vector lane holds the state or message word of a separate header. The
+// round logic is shared by the kernels over the vector operations below.
+
+#define LANE_COMPRESS(state, w) \
+{ \
+    auto a = state[0], b = state[1], c = state[2], d = state[3]; \
+    auto e = state[4], f = state[5], g = state[6], h = state[7]; \
+    for (size_t round = 0; round < 64; ++round) \
+    { \
+        auto& word = w[round % 16]; \
+        if (round >= 16) \
+            word = add(add(word, sigma0(w[(round - 15) % 16])), \
+                add(w[(round - 7) % 16], sigma1(w[(round - 2) % 16]))); \
+        const auto t1 = add(add(h, big_sigma1(e)), add(choose(e, f, g), \
+            add(set1(constants[round]), word))); \
+        const auto t2 = add(big_sigma0(a), majority(a, b, c)); \
+        h = g; g = f; f = e; e = add(d, t1); \
+        d = c; c = b; b = a; a = add(t1, t2); \
+    } \
+    state[0] = add(state[0], a); state[1] = add(state[1], b); \
+    state[2] = add(state[2], c); state[3] = add(state[3], d); \
+    state[4] = add(state[4], e); state[5] = add(state[5], f); \
+    state[6] = add(state[6], g); state[7] = add(state[7], h); \
+}
+
+#define LANE_HASH(vector, lanes, headers, stride, out) \
+{ \
+    alignas(64) uint32_t words[16][lanes]; \
+    vector state[8]; \
+    vector w[16]; \
+    for (size_t word = 0; word < 16; ++word) \
+        for (size_t lane = 0; lane < lanes; ++lane) \
+            words[word][lane] = load_big(headers + lane * stride + 4 * word); \
+    for (size_t word = 0; word < 16; ++word) \
+        w[word] = load(words[word]); \
+    for (size_t word = 0; word < 8; ++word) \
+        state[word] = set1(initial[word]); \
+    LANE_COMPRESS(state, w) \
+    for (size_t word = 0; word < 4; ++word) \
+        for (size_t lane = 0; lane < lanes; ++lane) \
+            words[word][lane] = load_big(headers + lane * stride + 64 + \
+                4 * word); \
+    for (size_t word = 0; word < 4; ++word) \
+        w[word] = load(words[word]); \
+    w[4] = set1(padding); \
+    for (size_t word = 5; word < 15; ++word) \
+        w[word] = set1(0); \
+    w[15] = set1(header_bits); \
+    LANE_COMPRESS(state, w) \
+    for (size_t word = 0; word < 8; ++word) \
+    { \
+        w[word] = state[word]; \
+        state[word] = set1(initial[word]); \
+    } \
+    w[8] = set1(padding); \
+    for (size_t word = 9; word < 15; ++word) \
+        w[word] = set1(0); \
+    w[15] = set1(digest_bits); \
+    LANE_COMPRESS(state, w) \
+    for (size_t word = 0; word < 8; ++word) \
+        store(words[word], state[word]); \
+    for (size_t lane = 0; lane < lanes; ++lane) \
+        for (size_t word = 0; word < 8; ++word) \
+            store_big(out[lane].data() + 4 * word, words[word][lane]); \
+}
+
+namespace avx2 {
+
+#define AVX2 __attribute__((target("avx2")))
+#define ROTATE(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), \
+    _mm256_slli_epi32(x, 32 - n))
+
+static const size_t lanes = 8;
+
+AVX2 static inline __m256i add(__m256i x, __m256i y)
+{
+    return _mm256_add_epi32(x, y);
+}
+
+AVX2 static inline __m256i set1(uint32_t value)
+{
+    return _mm256_set1_epi32(static_cast<int>(value));
+}
+
+AVX2 static inline __m256i load(const uint32_t* words)
+{
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+}
+
+AVX2 static inline void store(uint32_t* words, __m256i value)
+{
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words), value);
+}
+
+AVX2 static inline __m256i choose(__m256i e, __m256i f, __m256i g)
+{
+    return _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+}
+
+AVX2 static inline __m256i majority(__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_or_si256(_mm256_and_si256(a, b),
+        _mm256_and_si256(c, _mm256_or_si256(a, b)));
+}
+
+AVX2 static inline __m256i sigma0(__m256i x)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(ROTATE(x, 7), ROTATE(x, 18)),
+        _mm256_srli_epi32(x, 3));
+}
+
+AVX2 static inline __m256i sigma1(__m256i x)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(ROTATE(x, 17), ROTATE(x, 19)),
+        _mm256_srli_epi32(x, 10));
+}
+
+AVX2 static inline __m256i big_sigma0(__m256i x)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(ROTATE(x, 2), ROTATE(x, 13)),
+        ROTATE(x, 22));
+}
+
+AVX2 static inline __m256i big_sigma1(__m256i x)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(ROTATE(x, 6), ROTATE(x, 11)),
+        ROTATE(x, 25));
+}
+
+AVX2 static void hash(const uint8_t* headers, size_t stride, hash_digest* out)
+{
+    LANE_HASH(__m256i, lanes, headers, stride, out)
+}
+
+#undef ROTATE
+#undef AVX2
+
+} // namespace avx2
+
+namespace avx512 {
+
+#define AVX512 __attribute__((target("avx512f")))
+
+// The unmasked shift and rotate intrinsics merge into an undefined vector,
+// which GCC reports as maybe uninitialized. A full zeroing mask is the same
+// operation over a defined vector.
+#define ROTATE(x, n) _mm512_maskz_ror_epi32(full, x, n)
+#define SHIFT(x, n) _mm512_maskz_srli_epi32(full, x, n)
+
+static const __mmask16 full = 0xffff;
+
+static const size_t lanes = 16;
+
+AVX512 static inline __m512i add(__m512i x, __m512i y)
+{
+    return _mm512_add_epi32(x, y);
+}
+
+AVX512 static inline __m512i set1(uint32_t value)
+{
+    return _mm512_set1_epi32(static_cast<int>(value));
+}
+
+AVX512 static inline __m512i load(const uint32_t* words)
+{
+    return _mm512_load_si512(words);
+}
+
+AVX512 static inline void store(uint32_t* words, __m512i value)
+{
+    _mm512_store_si512(words, value);
+}
+
+// Ternary logic immediates: choose is (e ? f : g), majority of three.
+AVX512 static inline __m512i choose(__m512i e, __m512i f, __m512i g)
+{
+    return _mm512_ternarylogic_epi32(e, f, g, 0xca);
+}
+
+AVX512 static inline __m512i majority(__m512i a, __m512i b, __m512i c)
+{
+    return _mm512_ternarylogic_epi32(a, b, c, 0xe8);
+}
+
+AVX512 static inline __m512i sigma0(__m512i x)
+{
+    return _mm512_ternarylogic_epi32(ROTATE(x, 7),
+        ROTATE(x, 18), SHIFT(x, 3), 0x96);
+}
+
+AVX512 static inline __m512i sigma1(__m512i x)
+{
+    return _mm512_ternarylogic_epi32(ROTATE(x, 17),
+        ROTATE(x, 19), SHIFT(x, 10), 0x96);
+}
+
+AVX512 static inline __m512i big_sigma0(__m512i x)
+{
+    return _mm512_ternarylogic_epi32(ROTATE(x, 2),
+        ROTATE(x, 13), ROTATE(x, 22), 0x96);
+}
+
+AVX512 static inline __m512i big_sigma1(__m512i x)
+{
+    return _mm512_ternarylogic_epi32(ROTATE(x, 6),
+        ROTATE(x, 11), ROTATE(x, 25), 0x96);
+}
+
+AVX512 static void hash(const uint8_t* headers, size_t stride,
+    hash_digest* out)
+{
+    LANE_HASH(__m512i, lanes, headers, stride, out)
+}
+
+#undef SHIFT
+#undef ROTATE
+#undef AVX512
+
+} // namespace avx512
+
+#undef LANE_HASH
+#undef LANE_COMPRESS
+
+static bool detect(header_hasher::kernel use)
+{
+    typedef header_hasher::kernel kernel;
+    __builtin_cpu_init();
+
+    switch (use)
+    {
+        case kernel::sha_ni:
+        {
+            unsigned int a, b, c, d;
+            return __get_cpuid_count(7, 0, &a, &b, &c, &d) &&
+                (b & (1u << 29)) != 0 && __builtin_cpu_supports("sse4.1") &&
+                __builtin_cpu_supports("ssse3");
+        }
+        case kernel::avx2:
+            return __builtin_cpu_supports("avx2");
+        case kernel::avx512:
+            return __builtin_cpu_supports("avx512f");
+        case kernel::scalar:
+        default:
+            return true;
+    }
+}
+
+#else
+
+static bool detect(header_hasher::kernel use)
+{
+    return use == header_hasher::kernel::scalar;
+}
+
+#endif
+
+// Properties.
+// ----------------------------------------------------------------------------
+
+bool header_hasher::supported(kernel use)
+{
+    static const bool sha_ni = detect(kernel::sha_ni);
+    static const bool avx2 = detect(kernel::avx2);
+    static const bool avx512 = detect(kernel::avx512);
+
+    switch (use)
+    {
+        case kernel::sha_ni:
+            return sha_ni;
+        case kernel::avx2:
+            return avx2;
+        case kernel::avx512:
+            return avx512;
+        case kernel::scalar:
+        default:
+            return true;
+    }
+}
+
+// Lane width wins over the hardware rounds of a single buffer once a full
+// batch of lanes is available, SHA extensions then hash the remainder.
+header_hasher::kernel header_hasher::selected()
+{
+    static const auto best =
+        supported(kernel::avx512) ? kernel::avx512 :
+        supported(kernel::avx2) ? kernel::avx2 :
+        supported(kernel::sha_ni) ? kernel::sha_ni : kernel::scalar;
+
+    return best;
+}
+
+// Hashing.
+// ----------------------------------------------------------------------------
+
+void header_hasher::hash(const uint8_t* headers, size_t stride, size_t count,
+    hash_digest* out)
+{
+    hash(selected(), headers, stride, count, out);
+}
+
+void header_hasher::hash(kernel use, const uint8_t* headers, size_t stride,
+    size_t count, hash_digest* out)
+{
+    BITCOIN_ASSERT(supported(use));
+    BITCOIN_ASSERT(stride >= header_size);
+    size_t index = 0;
+
+#ifdef HAVE_X86_KERNELS
+    if (use == kernel::avx512)
+        for (; index + avx512::lanes <= count; index += avx512::lanes)
+            avx512::hash(headers + index * stride, stride, out + index);
+
+    if (use == kernel::avx512 || use == kernel::avx2)
+        for (; index + avx2::lanes <= count; index += avx2::lanes)
+            avx2::hash(headers + index * stride, stride, out + index);
+
+    if (supported(kernel::sha_ni) && use != kernel::scalar)
+    {
+        for (; index < count; ++index)
+            hash_sha_ni(headers + index * stride, out[index]);
+
+        return;
+    }
+#endif
+
+    for (; index < count; ++index)
+        hash_one(compress_scalar, headers + index * stride, out[index]);
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -64,6 +64,11 @@ size_t hosts::count() const
     ///////////////////////////////////////////////////////////////////////////
 }
 
+size_t hosts::memory_usage() const
+{
+    return buffer_.capacity() * sizeof(address);
+}
+
 code hosts::fetch(address& out) const
 {
     if (disabled_)
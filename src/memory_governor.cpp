@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/memory_governor.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// Inbound connections are refused at an eighth over budget and peers are
+// disconnected at a quarter over, as paused reads alone may not contain
+// the growth of queues.
+static size_t refuse_threshold(size_t budget)
+{
+    return budget + budget / 8;
+}
+
+static size_t disconnect_threshold(size_t budget)
+{
+    return budget + budget / 4;
+}
+
+static size_t to_index(memory_governor::category type)
+{
+    return static_cast<size_t>(type);
+}
+
+const char* memory_governor::name(category type)
+{
+    switch (type)
+    {
+        case category::payload:
+            return "payload";
+        case category::outbound:
+            return "outbound";
+        case category::relay:
+            return "relay";
+        case category::hosts:
+            return "hosts";
+        default:
+            return "unknown";
+    }
+}
+
+memory_governor::memory_governor(size_t budget,
+    const limits& category_limits)
+  : budget_(budget),
+    limits_(category_limits),
+    refuse_(refuse_threshold(budget)),
+    disconnect_(disconnect_threshold(budget)),
+    total_(0),
+    evicting_(false),
+    waiting_(false),
+    stopped_(true)
+{
+    for (auto& usage: usage_)
+        usage.store(0);
+}
+
+// Start/Stop.
+// ----------------------------------------------------------------------------
+
+void memory_governor::start(evict_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    stopped_ = false;
+    evict_ = handler;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void memory_governor::stop()
+{
+    std::vector<resume_handler> resumed;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    stopped_ = true;
+    evict_ = nullptr;
+    waiting_ = false;
+    std::swap(resumed, suspended_);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: resumed)
+        handler();
+}
+
+// Properties.
+// ----------------------------------------------------------------------------
+
+bool memory_governor::enabled() const
+{
+    return budget_ != 0 || std::any_of(limits_.begin(), limits_.end(),
+        [](size_t limit) { return limit != 0; });
+}
+
+size_t memory_governor::budget() const
+{
+    return budget_;
+}
+
+size_t memory_governor::limit(category type) const
+{
+    return limits_[to_index(type)];
+}
+
+size_t memory_governor::usage() const
+{
+    return total_.load();
+}
+
+size_t memory_governor::usage(category type) const
+{
+    return usage_[to_index(type)].load();
+}
+
+// Category limits only pause reads, the later stages follow the budget.
+memory_governor::pressure memory_governor::level() const
+{
+    const auto total = total_.load();
+
+    if (budget_ != 0 && total > disconnect_)
+        return pressure::disconnect;
+
+    if (budget_ != 0 && total > refuse_)
+        return pressure::refuse_inbound;
+
+    return paused() ? pressure::pause_reads : pressure::none;
+}
+
+bool memory_governor::paused() const
+{
+    if (over_budget())
+        return true;
+
+    for (size_t index = 0; index < categories; ++index)
+        if (limits_[index] != 0 && usage_[index].load() > limits_[index])
+            return true;
+
+    return false;
+}
+
+bool memory_governor::over(category type) const
+{
+    const auto limit = limits_[to_index(type)];
+    return over_budget() ||
+        (limit != 0 && usage_[to_index(type)].load() > limit);
+}
+
+// private
+bool memory_governor::over_budget() const
+{
+    return budget_ != 0 && total_.load() > budget_;
+}
+
+// Accounting.
+// ----------------------------------------------------------------------------
+
+void memory_governor::reserve(category type, size_t bytes)
+{
+    usage_[to_index(type)] += bytes;
+    const auto total = (total_ += bytes);
+
+    // Eviction is requested once for each entry into the disconnect stage.
+    if (budget_ == 0 || total <= disconnect_ || evicting_.exchange(true))
+        return;
+
+    evict_handler handler;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+        handler = evict_;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (handler)
+        handler();
+}
+
+void memory_governor::release(category type, size_t bytes)
+{
+    usage_[to_index(type)] -= bytes;
+    const auto total = (total_ -= bytes);
+
+    if (total <= disconnect_ && evicting_.load())
+        evicting_.store(false);
+
+    // Usage is written before the flag is read, and the flag is written by
+    // suspend before usage is read, so no wakeup is lost.
+    if (waiting_.load() && !paused())
+        resume();
+}
+
+// Suspension.
+// ----------------------------------------------------------------------------
+
+void memory_governor::suspend(resume_handler&& handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // The handler is released uninvoked, as readers are stopped.
+    if (stopped_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    waiting_ = true;
+
+    if (paused())
+    {
+        suspended_.push_back(std::move(handler));
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    waiting_ = !suspended_.empty();
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    handler();
+}
+
+void memory_governor::resume()
+{
+    std::vector<resume_handler> resumed;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // Usage may have grown again since the release.
+    if (paused())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    waiting_ = false;
+    std::swap(resumed, suspended_);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: resumed)
+        handler();
+}
+
+// Connection account.
+// ----------------------------------------------------------------------------
+
+memory_governor::account::account(memory_governor& governor)
+  : governor_(governor)
+{
+    for (auto& usage: usage_)
+        usage.store(0);
+}
+
+memory_governor::account::~account()
+{
+    for (size_t index = 0; index < categories; ++index)
+    {
+        const auto bytes = usage_[index].load();
+
+        if (bytes != 0)
+            governor_.release(static_cast<category>(index), bytes);
+    }
+}
+
+void memory_governor::account::reserve(category type, size_t bytes)
+{
+    usage_[to_index(type)] += bytes;
+    governor_.reserve(type, bytes);
+}
+
+void memory_governor::account::release(category type, size_t bytes)
+{
+    usage_[to_index(type)] -= bytes;
+    governor_.release(type, bytes);
+}
+
+size_t memory_governor::account::usage() const
+{
+    size_t total = 0;
+
+    for (const auto& usage: usage_)
+        total += usage.load();
+
+    return total;
+}
+
+size_t memory_governor::account::usage(category type) const
+{
+    return usage_[to_index(type)].load();
+}
+
+// Pausing the reads of a connection without backlog would release nothing.
+bool memory_governor::account::backlogged() const
+{
+    return (usage(category::relay) != 0 && governor_.over(category::relay)) ||
+        (usage(category::outbound) != 0 &&
+            governor_.over(category::outbound));
+}
+
+} // namespace network
+} // namespace libbitcoin
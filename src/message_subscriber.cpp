@@ -21,28 +21,56 @@
 #include <istream>
 #include <memory>
 #include <string>
+#include <utility>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 
 #define INITIALIZE_SUBSCRIBER(pool, value) \
-    value##_subscriber_(std::make_shared<value##_subscriber_type>( \
-        pool, #value "_sub"))
+    value##_subscriber_(std::allocate_shared<value##_subscriber_type>( \
+        allocator, pool, #value "_sub"))
+
+#define INITIALIZE_INLINE_SUBSCRIBER(pool, value) \
+    value##_inline_subscriber_(std::allocate_shared<value##_subscriber_type>( \
+        allocator, pool, #value "_inline_sub"))
 
 #define RELAY_CODE(code, value) \
+    value##_inline_subscriber_->relay(code, {}); \
     value##_subscriber_->relay(code, {})
 
 // This allows us to block the peer while handling the message.
-#define CASE_HANDLE_MESSAGE(stream, version, value) \
+#define CASE_HANDLE_MESSAGE(source, version, resume, value, lane) \
+    case message_type::value: \
+        return handle<message::value>(message_type::value, source, version, \
+            value##_subscriber_, value##_inline_subscriber_, priority::lane, \
+            std::move(resume))
+
+#define CASE_RELAY_MESSAGE(source, version, resume, value) \
+    case message_type::value: \
+        return relay<message::value>(message_type::value, source, version, \
+            value##_subscriber_, value##_inline_subscriber_, priority::bulk, \
+            std::move(resume))
+
+// Liveness and peer configuration messages run ahead of payload handling.
+#define CASE_CONTROL_MESSAGE(stream, version, resume, value) \
     case message_type::value: \
-        return handle<message::value>(stream, version, value##_subscriber_)
+        return relay<message::value>(message_type::value, stream, version, \
+            value##_subscriber_, value##_inline_subscriber_, \
+            priority::control, std::move(resume))
 
-#define CASE_RELAY_MESSAGE(stream, version, value) \
+// Decode and notification follow the reader, in order (see pipelined).
+#define CASE_PIPELINE_MESSAGE(version, payload, complete, value) \
     case message_type::value: \
-        return relay<message::value>(stream, version, value##_subscriber_)
+        pipeline<message::value>(message_type::value, version, payload, \
+            value##_subscriber_, value##_inline_subscriber_, \
+            std::move(complete)); \
+        return
 
 #define START_SUBSCRIBER(value) \
+    value##_inline_subscriber_->start(); \
     value##_subscriber_->start()
 
 #define STOP_SUBSCRIBER(value) \
+    value##_inline_subscriber_->stop(); \
     value##_subscriber_->stop()
 
 namespace libbitcoin {
@@ -50,8 +78,34 @@ namespace network {
 
 using namespace message;
 
-message_subscriber::message_subscriber(threadpool& pool)
-  : INITIALIZE_SUBSCRIBER(pool, address),
+// Smaller blocks are not worth the cost of scanning and coordination.
+static const size_t parallel_decode_minimum = 1000000;
+
+static priority_dispatcher::strand::ptr make_strand(
+    priority_dispatcher& dispatch,
+    const connection_slab::byte_allocator& allocator)
+{
+    return std::allocate_shared<priority_dispatcher::strand>(allocator,
+        dispatch);
+}
+
+message_subscriber::message_subscriber(threadpool& pool,
+    priority_dispatcher& dispatch,
+    const connection_slab::byte_allocator& allocator, bool ordered,
+    bool ahead, bool parallel, bool retain)
+  : dispatch_(dispatch),
+    retain_(retain),
+    decoded_(0),
+    inline_(0),
+    raw_(0),
+    raw_subscriber_(std::allocate_shared<raw_subscriber_type>(allocator,
+        pool, "raw_sub")),
+    ahead_(ahead),
+    control_(make_strand(dispatch, allocator)),
+    bulk_(ordered ? control_ : make_strand(dispatch, allocator)),
+    decoder_(dispatch.pool(), parallel ? parallel_decode_minimum :
+        max_size_t),
+    INITIALIZE_SUBSCRIBER(pool, address),
     INITIALIZE_SUBSCRIBER(pool, alert),
     INITIALIZE_SUBSCRIBER(pool, block),
     INITIALIZE_SUBSCRIBER(pool, block_transactions),
@@ -77,12 +131,130 @@ message_subscriber::message_subscriber(threadpool& pool)
     INITIALIZE_SUBSCRIBER(pool, send_headers),
     INITIALIZE_SUBSCRIBER(pool, transaction),
     INITIALIZE_SUBSCRIBER(pool, verack),
-    INITIALIZE_SUBSCRIBER(pool, version)
+    INITIALIZE_SUBSCRIBER(pool, version),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, address),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, alert),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, block),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, block_transactions),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, compact_block),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, fee_filter),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, filter_add),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, filter_clear),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, filter_load),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, get_address),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, get_blocks),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, get_block_transactions),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, get_data),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, get_headers),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, headers),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, inventory),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, memory_pool),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, merkle_block),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, not_found),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, ping),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, pong),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, reject),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, send_compact),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, send_headers),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, transaction),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, verack),
+    INITIALIZE_INLINE_SUBSCRIBER(pool, version)
 {
 }
 
+bool message_subscriber::pipelined(message_type type)
+{
+    return type == message_type::block || type == message_type::headers ||
+        type == message_type::transaction;
+}
+
+bool message_subscriber::decode(message::block& message, uint32_t version,
+    const data_chunk& payload) const
+{
+    return decoder_.decode(version, payload, message);
+}
+
+bool message_subscriber::decode(message::transaction& message,
+    uint32_t version, const data_chunk& payload) const
+{
+    return decoder_.decode(version, payload, message);
+}
+
+bool message_subscriber::decode(message::headers& message, uint32_t version,
+    const data_chunk& payload) const
+{
+    return decoder_.decode(version, payload, message);
+}
+
+// Only relayed messages are worth retaining for forwarding.
+bool message_subscriber::retained(message_type type) const
+{
+    return retain_ && (type == message_type::block ||
+        type == message_type::transaction);
+}
+
+// Types without an inline handler skip the inline subscriber and its lock.
+bool message_subscriber::inlined(message_type type) const
+{
+    return (inline_ & to_bit(type)) != 0;
+}
+
+// Raw subscription.
+// ----------------------------------------------------------------------------
+
+void message_subscriber::subscribe_raw(message_type type,
+    raw_handler&& handler)
+{
+    raw_ |= to_bit(type);
+
+    // All raw handlers share a subscriber, each skips other message types.
+    raw_subscriber_->subscribe(
+        [type, handler = std::move(handler)](const code& ec,
+            const heading& head,
+            payload_ptr payload)
+        {
+            return (!ec && head.type() != type) || handler(ec, head, payload);
+        }, error::channel_stopped, {}, nullptr);
+}
+
+bool message_subscriber::raw(message_type type) const
+{
+    return (raw_ & to_bit(type)) != 0;
+}
+
+bool message_subscriber::decoded(message_type type) const
+{
+    return (decoded_ & to_bit(type)) != 0;
+}
+
+void message_subscriber::relay_raw(const heading& head, payload_ptr payload,
+    priority_dispatcher::job&& resume) const
+{
+    const auto subscriber = raw_subscriber_;
+
+    // In arrival order with the decoded bulk messages of the channel.
+    post(priority::bulk, [subscriber, head, payload]()
+    {
+        subscriber->invoke(error::success, head, payload);
+    });
+
+    dispatch_.resume(std::move(resume));
+}
+
+// Messages of one lane from one peer are handled in arrival order and never
+// concurrently, while channels, and the lanes of a channel, run in parallel.
+// In ordered mode both lanes share one strand, so all messages of the
+// channel are handled in arrival order.
+void message_subscriber::post(priority lane,
+    priority_dispatcher::job&& handler) const
+{
+    const auto& strand = lane == priority::control ? control_ : bulk_;
+    strand->post(lane, std::move(handler));
+}
+
 void message_subscriber::broadcast(const code& ec)
 {
+    raw_subscriber_->relay(ec, {}, nullptr);
     RELAY_CODE(ec, address);
     RELAY_CODE(ec, alert);
     RELAY_CODE(ec, block);
@@ -113,45 +285,92 @@ void message_subscriber::broadcast(const code& ec)
 }
 
 code message_subscriber::load(message_type type, uint32_t version,
-    std::istream& stream) const
+    std::istream& stream, priority_dispatcher::job&& resume) const
 {
     switch (type)
     {
-        CASE_RELAY_MESSAGE(stream, version, address);
-        CASE_RELAY_MESSAGE(stream, version, alert);
-        CASE_HANDLE_MESSAGE(stream, version, block);
-        CASE_RELAY_MESSAGE(stream, version, block_transactions);
-        CASE_RELAY_MESSAGE(stream, version, compact_block);
-        CASE_RELAY_MESSAGE(stream, version, fee_filter);
-        CASE_RELAY_MESSAGE(stream, version, filter_add);
-        CASE_RELAY_MESSAGE(stream, version, filter_clear);
-        CASE_RELAY_MESSAGE(stream, version, filter_load);
-        CASE_RELAY_MESSAGE(stream, version, get_address);
-        CASE_RELAY_MESSAGE(stream, version, get_blocks);
-        CASE_RELAY_MESSAGE(stream, version, get_block_transactions);
-        CASE_RELAY_MESSAGE(stream, version, get_data);
-        CASE_RELAY_MESSAGE(stream, version, get_headers);
-        CASE_RELAY_MESSAGE(stream, version, headers);
-        CASE_RELAY_MESSAGE(stream, version, inventory);
-        CASE_RELAY_MESSAGE(stream, version, memory_pool);
-        CASE_RELAY_MESSAGE(stream, version, merkle_block);
-        CASE_RELAY_MESSAGE(stream, version, not_found);
-        CASE_RELAY_MESSAGE(stream, version, ping);
-        CASE_RELAY_MESSAGE(stream, version, pong);
-        CASE_RELAY_MESSAGE(stream, version, reject);
-        CASE_RELAY_MESSAGE(stream, version, send_compact);
-        CASE_RELAY_MESSAGE(stream, version, send_headers);
-        CASE_HANDLE_MESSAGE(stream, version, transaction);
-        CASE_HANDLE_MESSAGE(stream, version, verack);
-        CASE_HANDLE_MESSAGE(stream, version, version);
+        CASE_RELAY_MESSAGE(stream, version, resume, address);
+        CASE_RELAY_MESSAGE(stream, version, resume, alert);
+        CASE_HANDLE_MESSAGE(stream, version, resume, block, bulk);
+        CASE_RELAY_MESSAGE(stream, version, resume, block_transactions);
+        CASE_RELAY_MESSAGE(stream, version, resume, compact_block);
+        CASE_CONTROL_MESSAGE(stream, version, resume, fee_filter);
+        CASE_RELAY_MESSAGE(stream, version, resume, filter_add);
+        CASE_RELAY_MESSAGE(stream, version, resume, filter_clear);
+        CASE_RELAY_MESSAGE(stream, version, resume, filter_load);
+        CASE_RELAY_MESSAGE(stream, version, resume, get_address);
+        CASE_RELAY_MESSAGE(stream, version, resume, get_blocks);
+        CASE_RELAY_MESSAGE(stream, version, resume, get_block_transactions);
+        CASE_RELAY_MESSAGE(stream, version, resume, get_data);
+        CASE_RELAY_MESSAGE(stream, version, resume, get_headers);
+        CASE_RELAY_MESSAGE(stream, version, resume, headers);
+        CASE_RELAY_MESSAGE(stream, version, resume, inventory);
+        CASE_RELAY_MESSAGE(stream, version, resume, memory_pool);
+        CASE_RELAY_MESSAGE(stream, version, resume, merkle_block);
+        CASE_RELAY_MESSAGE(stream, version, resume, not_found);
+        CASE_CONTROL_MESSAGE(stream, version, resume, ping);
+        CASE_CONTROL_MESSAGE(stream, version, resume, pong);
+        CASE_CONTROL_MESSAGE(stream, version, resume, reject);
+        CASE_CONTROL_MESSAGE(stream, version, resume, send_compact);
+        CASE_CONTROL_MESSAGE(stream, version, resume, send_headers);
+        CASE_HANDLE_MESSAGE(stream, version, resume, transaction, bulk);
+        CASE_HANDLE_MESSAGE(stream, version, resume, verack, control);
+        CASE_HANDLE_MESSAGE(stream, version, resume, version, control);
         case message_type::unknown:
         default:
             return error::not_found;
     }
 }
 
+// Pipelined types are handled as when loaded from a stream.
+code message_subscriber::decode(message_type type, uint32_t version,
+    const data_chunk& payload, priority_dispatcher::job&& resume) const
+{
+    switch (type)
+    {
+        CASE_HANDLE_MESSAGE(payload, version, resume, block, bulk);
+        CASE_RELAY_MESSAGE(payload, version, resume, headers);
+        CASE_HANDLE_MESSAGE(payload, version, resume, transaction, bulk);
+        default:
+            return error::not_found;
+    }
+}
+
+code message_subscriber::decode(message_type type, uint32_t version,
+    payload_ptr payload, priority_dispatcher::job&& resume) const
+{
+    switch (type)
+    {
+        CASE_HANDLE_MESSAGE(payload, version, resume, block, bulk);
+        CASE_RELAY_MESSAGE(payload, version, resume, headers);
+        CASE_HANDLE_MESSAGE(payload, version, resume, transaction, bulk);
+        default:
+            return error::not_found;
+    }
+}
+
+void message_subscriber::load(message_type type, uint32_t version,
+    payload_ptr payload, result_handler&& complete) const
+{
+    if (!ahead_)
+    {
+        complete(error::operation_failed);
+        return;
+    }
+
+    switch (type)
+    {
+        CASE_PIPELINE_MESSAGE(version, payload, complete, block);
+        CASE_PIPELINE_MESSAGE(version, payload, complete, headers);
+        CASE_PIPELINE_MESSAGE(version, payload, complete, transaction);
+        default:
+            complete(error::not_found);
+    }
+}
+
 void message_subscriber::start()
 {
+    raw_subscriber_->start();
     START_SUBSCRIBER(address);
     START_SUBSCRIBER(alert);
     START_SUBSCRIBER(block);
@@ -183,6 +402,7 @@ void message_subscriber::start()
 
 void message_subscriber::stop()
 {
+    raw_subscriber_->stop();
     STOP_SUBSCRIBER(address);
     STOP_SUBSCRIBER(alert);
     STOP_SUBSCRIBER(block);
@@ -30,6 +30,8 @@
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/memory_governor.hpp>
+#include <bitcoin/network/priority_dispatcher.hpp>
 #include <bitcoin/network/protocols/protocol_address_31402.hpp>
 #include <bitcoin/network/protocols/protocol_ping_31402.hpp>
 #include <bitcoin/network/protocols/protocol_ping_60001.hpp>
@@ -41,6 +43,9 @@
 #include <bitcoin/network/sessions/session_outbound.hpp>
 #include <bitcoin/network/sessions/session_seed.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/thread_placement.hpp>
+#include <bitcoin/network/thread_scaler.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -50,6 +55,9 @@ namespace network {
 using namespace bc::config;
 using namespace std::placeholders;
 
+// Channel and protocol timeouts are all whole seconds or longer.
+static const auto timer_resolution = asio::milliseconds(100);
+
 // This can be exceeded due to manual connection calls and race conditions.
 inline size_t nominal_connecting(const settings& settings)
 {
@@ -64,10 +72,41 @@ inline size_t nominal_connected(const settings& settings)
         settings.inbound_connections;
 }
 
+inline size_t to_bytes(uint32_t megabytes)
+{
+    return static_cast<size_t>(megabytes) * 1024 * 1024;
+}
+
+// The host pool is bounded by its capacity, so hosts has no limit.
+inline memory_governor::limits memory_limits(const settings& settings)
+{
+    typedef memory_governor::category category;
+    memory_governor::limits limits{};
+    limits[static_cast<size_t>(category::payload)] =
+        to_bytes(settings.memory_payload_megabytes);
+    limits[static_cast<size_t>(category::outbound)] =
+        to_bytes(settings.memory_outbound_megabytes);
+    limits[static_cast<size_t>(category::relay)] =
+        to_bytes(settings.memory_relay_megabytes);
+    return limits;
+}
+
 p2p::p2p(const settings& settings)
   : settings_(settings),
     stopped_(true),
     top_block_({ null_hash, 0 }),
+    timers_(threadpool_, timer_resolution, thread_default(settings_.threads)),
+    lanes_(handler_pool_, thread_default(settings_.handler_threads),
+        settings_.handler_queue_limit),
+    placement_(settings_.thread_affinity, settings_.numa_placement),
+    scaler_(handler_pool_, timers_, lanes_, placement_,
+        thread_default(settings_.threads),
+        thread_default(settings_.handler_threads), settings_.thread_maximum),
+    payloads_(settings_.payload_cache_capacity),
+    slab_(nominal_connecting(settings_) + nominal_connected(settings_),
+        settings_.connection_slab_size),
+    governor_(to_bytes(settings_.memory_budget_megabytes),
+        memory_limits(settings_)),
     hosts_(settings_),
     pending_connect_(nominal_connecting(settings_)),
     pending_handshake_(nominal_connected(settings_)),
@@ -77,6 +116,7 @@ p2p::p2p(const settings& settings)
     channel_subscriber_(std::make_shared<channel_subscriber>(threadpool_,
         NAME "_sub"))
 {
+    governor_.reserve(memory_governor::category::hosts, hosts_.memory_usage());
 }
 
 // This allows for shutdown based on destruct without need to call stop.
@@ -97,10 +137,26 @@ void p2p::start(result_handler handler)
     }
 
     threadpool_.join();
-    threadpool_.spawn(thread_default(settings_.threads),
-        thread_priority::normal);
+    handler_pool_.join();
+
+    // Sockets and timers are never queued behind message handlers.
+    const auto threads = thread_default(settings_.threads);
+    const auto handlers = thread_default(settings_.handler_threads);
+    threadpool_.spawn(threads, thread_priority::normal);
+    handler_pool_.spawn(handlers, thread_priority::normal);
+
+    // Bind the idle threads before any work is queued to the pools. Handler
+    // threads are placed after network threads, not on the same processors.
+    const auto bound = placement_.apply(threadpool_, threads);
+
+    if (!placement_.apply(handler_pool_, handlers, threads) || !bound)
+        LOG_WARNING(LOG_NETWORK)
+            << "Failed to bind all network threads to processors.";
 
     stopped_ = false;
+    timers_.start();
+    scaler_.start();
+    governor_.start(std::bind(&p2p::handle_memory_pressure, this));
     stop_subscriber_->start();
     channel_subscriber_->start();
 
@@ -288,8 +344,35 @@ bool p2p::stop()
     pending_handshake_.stop(error::service_stopped);
     pending_close_.stop(error::service_stopped);
 
-    // Signal threadpool to stop accepting work now that subscribers are clear.
+    // Release suspended reads so that their channels can be freed.
+    governor_.stop();
+
+    // Stop ticking so the threadpool can drain and join.
+    timers_.stop();
+
+    // Release parked threads so that the threadpool can join.
+    scaler_.stop();
+
+    if (payloads_.enabled())
+        LOG_INFO(LOG_NETWORK)
+            << "Payload cache dropped " << payloads_.hits()
+            << " duplicates of " << payloads_.lookups() << " lookups.";
+
+    if (governor_.enabled())
+        LOG_INFO(LOG_NETWORK)
+            << "Memory usage " << governor_.usage() << " of "
+            << governor_.budget() << " bytes (payload "
+            << governor_.usage(memory_governor::category::payload)
+            << ", outbound "
+            << governor_.usage(memory_governor::category::outbound)
+            << ", relay "
+            << governor_.usage(memory_governor::category::relay)
+            << ", hosts "
+            << governor_.usage(memory_governor::category::hosts) << ").";
+
+    // Signal threadpools to stop accepting work now that subscribers are clear.
     threadpool_.shutdown();
+    handler_pool_.shutdown();
     return result;
 }
 
@@ -299,8 +382,9 @@ bool p2p::close()
     // Signal current work to stop and threadpool to stop accepting new work.
     const auto result = p2p::stop();
 
-    // Block on join of all threads in the threadpool.
+    // Block on join of all threads in the threadpools.
     threadpool_.join();
+    handler_pool_.join();
     return result;
 }
 
@@ -337,6 +421,90 @@ threadpool& p2p::thread_pool()
     return threadpool_;
 }
 
+threadpool& p2p::handler_pool()
+{
+    return handler_pool_;
+}
+
+timer_wheel& p2p::timers()
+{
+    return timers_;
+}
+
+priority_dispatcher& p2p::lanes()
+{
+    return lanes_;
+}
+
+thread_scaler& p2p::scaler()
+{
+    return scaler_;
+}
+
+payload_cache& p2p::payloads()
+{
+    return payloads_;
+}
+
+connection_slab& p2p::slab()
+{
+    return slab_;
+}
+
+memory_governor& p2p::governor()
+{
+    return governor_;
+}
+
+// Memory budget.
+// ----------------------------------------------------------------------------
+
+// private
+// This is invoked on the reserving thread, which may be reading a channel.
+void p2p::handle_memory_pressure()
+{
+    threadpool_.service().post(std::bind(&p2p::evict_channels, this));
+}
+
+// private
+// Peers are stopped in order of memory held until the usage they account for
+// brings the network within budget. Their memory is released as their
+// buffers and queued work are freed.
+void p2p::evict_channels()
+{
+    if (stopped())
+        return;
+
+    typedef std::pair<size_t, channel::ptr> holding;
+    std::vector<holding> holdings;
+
+    // Usage is sampled once, as it changes while sorting.
+    for (const auto channel: pending_close_.collection())
+        holdings.emplace_back(channel->memory_usage(), channel);
+
+    std::sort(holdings.begin(), holdings.end(),
+        [](const holding& left, const holding& right)
+        {
+            return left.first > right.first;
+        });
+
+    auto usage = governor_.usage();
+    const auto budget = governor_.budget();
+
+    for (const auto& entry: holdings)
+    {
+        if (usage <= budget || entry.first == 0)
+            break;
+
+        LOG_INFO(LOG_NETWORK)
+            << "Disconnecting [" << entry.second->authority() << "] holding "
+            << entry.first << " bytes over memory budget.";
+
+        entry.second->stop(error::channel_stopped);
+        usage -= std::min(usage, entry.first);
+    }
+}
+
 // Send.
 // ----------------------------------------------------------------------------
 
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/payload_cache.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// Independent locks keep concurrent channels from contending on lookup.
+static const size_t shard_count = 16;
+
+payload_cache::payload_cache(size_t capacity)
+  : lookups_(0),
+    hits_(0)
+{
+    if (capacity == 0)
+        return;
+
+    const auto per_shard = (capacity + shard_count - 1) / shard_count;
+    shards_.reserve(shard_count);
+
+    for (size_t index = 0; index < shard_count; ++index)
+        shards_.emplace_back(new shard(per_shard));
+}
+
+bool payload_cache::enabled() const
+{
+    return !shards_.empty();
+}
+
+uint64_t payload_cache::lookups() const
+{
+    return lookups_.load(std::memory_order_relaxed);
+}
+
+uint64_t payload_cache::hits() const
+{
+    return hits_.load(std::memory_order_relaxed);
+}
+
+// Cache.
+// ----------------------------------------------------------------------------
+
+// The checksum is peer supplied, so the shard is also only a hint.
+payload_cache::shard& payload_cache::select(uint32_t checksum)
+{
+    BITCOIN_ASSERT(enabled());
+    return *shards_[checksum % shards_.size()];
+}
+
+// The leading and trailing bytes, as the length is part of the key.
+payload_cache::sample payload_cache::to_sample(const data_chunk& payload)
+{
+    sample bytes{};
+    const size_t half = sample_size;
+    const auto head = std::min(payload.size(), half);
+    const auto tail = std::min(payload.size() - head, half);
+    std::copy_n(payload.begin(), head, bytes.begin());
+    std::copy_n(payload.end() - tail, tail, bytes.begin() + half);
+    return bytes;
+}
+
+bool payload_cache::duplicate(message::message_type type, uint32_t checksum,
+    const data_chunk& payload)
+{
+    if (!enabled())
+        return false;
+
+    lookups_.fetch_add(1, std::memory_order_relaxed);
+    const auto found = select(checksum).duplicate(
+        std::make_tuple(type, checksum, payload.size()), payload);
+
+    if (found)
+        hits_.fetch_add(1, std::memory_order_relaxed);
+
+    return found;
+}
+
+// Shard.
+// ----------------------------------------------------------------------------
+
+payload_cache::shard::shard(size_t capacity)
+  : capacity_(std::max(capacity, size_t(1))),
+    sequence_(0)
+{
+}
+
+bool payload_cache::shard::duplicate(const key& value,
+    const data_chunk& payload)
+{
+    const auto bytes = to_sample(payload);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto it = entries_.find(value);
+
+    // A colliding key with other bytes replaces the entry.
+    if (it == entries_.end() || it->second.bytes != bytes)
+    {
+        const auto sequence = store(value, bytes);
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        hash(value, sequence, payload);
+        return false;
+    }
+
+    const auto hashed = it->second.hashed;
+    const auto known = it->second.digest;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // A repeat that races the hash of the first payload cannot be confirmed.
+    return hashed && sha256_hash(payload) == known;
+}
+
+// The first payload is hashed outside of the lock, so that its first repeat
+// is dropped. A hash is thereby only ever that of a relayed payload.
+void payload_cache::shard::hash(const key& value, uint64_t sequence,
+    const data_chunk& payload)
+{
+    const auto digest = sha256_hash(payload);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto entry = entries_.find(value);
+
+    if (entry != entries_.end() && entry->second.sequence == sequence)
+    {
+        entry->second.digest = digest;
+        entry->second.hashed = true;
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Call under lock, a stale order record of a replaced entry is skipped.
+uint64_t payload_cache::shard::store(const key& value,
+    const sample& bytes)
+{
+    const auto sequence = ++sequence_;
+    entries_[value] = entry{ bytes, null_hash, false, sequence };
+    order_.emplace_back(value, sequence);
+
+    while (order_.size() > capacity_)
+    {
+        const auto& oldest = order_.front();
+        const auto it = entries_.find(oldest.first);
+
+        if (it != entries_.end() && it->second.sequence == oldest.second)
+            entries_.erase(it);
+
+        order_.pop_front();
+    }
+
+    return sequence;
+}
+
+} // namespace network
+} // namespace libbitcoin
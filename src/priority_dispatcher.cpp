@@ -0,0 +1,296 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/priority_dispatcher.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+priority_dispatcher::priority_dispatcher(threadpool& pool, size_t concurrency,
+    size_t capacity)
+  : pool_(pool),
+    capacity_(capacity),
+    concurrency_(std::max(concurrency, size_t(1))),
+    scheduled_(0),
+    queued_(0),
+    stranded_(0)
+{
+}
+
+void priority_dispatcher::post(priority lane, job&& handler)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    queues_[static_cast<size_t>(lane)].push_back(std::move(handler));
+    ++queued_;
+    const auto schedule_run = scheduled_ < concurrency_;
+
+    if (schedule_run)
+        ++scheduled_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (schedule_run)
+        schedule();
+}
+
+void priority_dispatcher::resume(job&& handler)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto ready = capacity_ == 0 || queued_ + stranded_ < capacity_;
+
+    if (!ready)
+        waiting_.push_back(std::move(handler));
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (ready)
+        handler();
+}
+
+void priority_dispatcher::set_concurrency(size_t concurrency)
+{
+    size_t runs = 0;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    concurrency_ = std::max(concurrency, size_t(1));
+
+    // Excess runs retire as they complete, missing runs are scheduled now.
+    const auto target = std::min(queued_, concurrency_);
+
+    if (target > scheduled_)
+    {
+        runs = target - scheduled_;
+        scheduled_ = target;
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (size_t run = 0; run < runs; ++run)
+        schedule();
+}
+
+threadpool& priority_dispatcher::pool()
+{
+    return pool_;
+}
+
+size_t priority_dispatcher::size(priority lane) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return queues_[static_cast<size_t>(lane)].size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+void priority_dispatcher::schedule()
+{
+    pool_.service().post(
+        std::bind(&priority_dispatcher::run,
+            this));
+}
+
+// Run one job and then yield the thread back to the pool, rescheduling if
+// work remains. This keeps the pool queue short so that completions posted
+// by sockets and timers are not starved by a backlog of bulk jobs.
+void priority_dispatcher::run()
+{
+    job handler;
+    queue resumed;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (auto& queue: queues_)
+    {
+        if (!queue.empty())
+        {
+            handler = std::move(queue.front());
+            queue.pop_front();
+            --queued_;
+            break;
+        }
+    }
+
+    if (!handler)
+        --scheduled_;
+
+    take_waiting(resumed);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (auto& resume: resumed)
+        resume();
+
+    if (!handler)
+        return;
+
+    handler();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto empty = std::all_of(queues_.begin(), queues_.end(),
+        [](const queue& queue) { return queue.empty(); });
+
+    // Retire this run if concurrency has been reduced below the run count.
+    const auto more = !empty && scheduled_ <= concurrency_;
+
+    if (!more)
+        --scheduled_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (more)
+        schedule();
+}
+
+// Jobs waiting on a strand count against capacity until the strand takes
+// them, otherwise an ordered channel could queue without bound.
+void priority_dispatcher::strand_posted()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    ++stranded_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void priority_dispatcher::strand_taken()
+{
+    queue resumed;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    --stranded_;
+    take_waiting(resumed);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (auto& resume: resumed)
+        resume();
+}
+
+// Take as many deferred readers as there is capacity for, call under lock.
+void priority_dispatcher::take_waiting(queue& resumed)
+{
+    while (!waiting_.empty() &&
+        queued_ + stranded_ + resumed.size() < capacity_)
+    {
+        resumed.push_back(std::move(waiting_.front()));
+        waiting_.pop_front();
+    }
+}
+
+// Strand.
+// ----------------------------------------------------------------------------
+
+priority_dispatcher::strand::strand(priority_dispatcher& dispatch)
+  : dispatch_(dispatch),
+    running_(false)
+{
+}
+
+void priority_dispatcher::strand::post(priority lane, job&& handler)
+{
+    dispatch_.strand_posted();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    queue_.emplace_back(lane, std::move(handler));
+    const auto start = !running_;
+    running_ = true;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (start)
+        dispatch_.post(lane,
+            std::bind(&strand::run,
+                shared_from_this()));
+}
+
+// Only one run is queued or executing at a time, which orders the jobs.
+void priority_dispatcher::strand::run()
+{
+    job handler;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    handler = std::move(queue_.front().second);
+    queue_.pop_front();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    dispatch_.strand_taken();
+    handler();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto more = !queue_.empty();
+    const auto lane = more ? queue_.front().first : priority::bulk;
+    running_ = more;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (more)
+        dispatch_.post(lane,
+            std::bind(&strand::run,
+                shared_from_this()));
+}
+
+} // namespace network
+} // namespace libbitcoin
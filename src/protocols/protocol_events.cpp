@@ -19,6 +19,8 @@
 #include <bitcoin/network/protocols/protocol_events.hpp>
 
 #include <functional>
+#include <memory>
+#include <utility>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
@@ -65,7 +67,7 @@ void protocol_events::start()
 
 void protocol_events::start(event_handler handler)
 {
-    handler_.store(handler);
+    handler_.store(std::make_shared<const event_handler>(std::move(handler)));
     SUBSCRIBE_STOP1(handle_stopped, _1);
 }
 
@@ -91,7 +93,7 @@ void protocol_events::handle_stopped(const code& ec)
 void protocol_events::set_event(const code& ec)
 {
     // If already stopped.
-    auto handler = handler_.load();
+    const auto handler = handler_.load();
     if (!handler)
         return;
 
@@ -100,7 +102,7 @@ void protocol_events::set_event(const code& ec)
         handler_.store(nullptr);
 
     // Invoke event handler.
-    handler(ec);
+    (*handler)(ec);
 }
 
 } // namespace network
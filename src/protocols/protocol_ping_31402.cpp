@@ -45,7 +45,7 @@ void protocol_ping_31402::start()
 {
     protocol_timer::start(settings_.channel_heartbeat(), BIND1(send_ping, _1));
 
-    SUBSCRIBE2(ping, handle_receive_ping, _1, _2);
+    SUBSCRIBE_INLINE2(ping, handle_receive_ping, _1, _2);
 
     // Send initial ping message by simulating first heartbeat.
     set_event(error::success);
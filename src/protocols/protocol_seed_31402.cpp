@@ -19,6 +19,8 @@
 #include <bitcoin/network/protocols/protocol_seed_31402.hpp>
 
 #include <functional>
+#include <memory>
+#include <utility>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
@@ -48,7 +50,10 @@ protocol_seed_31402::protocol_seed_31402(p2p& network, channel::ptr channel)
 void protocol_seed_31402::start(event_handler handler)
 {
     const auto& settings = network_.network_settings();
-    const event_handler complete = BIND2(handle_seeding_complete, _1, handler);
+    // The synchronizer copies its handler, so the move-only handler is shared.
+    const auto shared = std::make_shared<const event_handler>(
+        BIND2(handle_seeding_complete, _1, std::move(handler)));
+    const auto complete = [shared](const code& ec) { (*shared)(ec); };
 
     if (settings.host_pool_capacity == 0)
     {
@@ -84,7 +89,7 @@ void protocol_seed_31402::send_own_address(const settings& settings)
 }
 
 void protocol_seed_31402::handle_seeding_complete(const code& ec,
-    event_handler handler)
+    const event_handler& handler)
 {
     handler(ec);
     stop(ec);
@@ -21,10 +21,12 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -35,7 +37,8 @@ using namespace std::placeholders;
 protocol_timer::protocol_timer(p2p& network, channel::ptr channel,
     bool perpetual, const std::string& name)
   : protocol_events(network, channel, name),
-    perpetual_(perpetual)
+    perpetual_(perpetual),
+    timers_(network.timers())
 {
 }
 
@@ -46,13 +49,14 @@ protocol_timer::protocol_timer(p2p& network, channel::ptr channel,
 void protocol_timer::start(const asio::duration& timeout,
     event_handler handle_event)
 {
-    // The deadline timer is thread safe.
-    timer_ = std::make_shared<deadline>(pool(), timeout);
-    protocol_events::start(BIND2(handle_notify, _1, handle_event));
+    // The wheel timer is thread safe.
+    timer_ = std::make_shared<timer_wheel::timer>(timers_, timeout);
+    protocol_events::start(BIND2(handle_notify, _1, std::move(handle_event)));
     reset_timer();
 }
 
-void protocol_timer::handle_notify(const code& ec, event_handler handler)
+void protocol_timer::handle_notify(const code& ec,
+    const event_handler& handler)
 {
     if (ec == error::channel_stopped)
         timer_->stop();
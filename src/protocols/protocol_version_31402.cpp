@@ -20,6 +20,8 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <utility>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
@@ -75,14 +77,21 @@ void protocol_version_31402::start(event_handler handler)
 {
     const auto period = network_.network_settings().channel_handshake();
 
-    const auto join_handler = synchronize(handler, 2, NAME,
+    // The synchronizer copies its handler, so the move-only handler is shared.
+    const auto shared = std::make_shared<const event_handler>(
+        std::move(handler));
+    const auto complete = [shared](const code& ec) { (*shared)(ec); };
+    const auto join_handler = synchronize(complete, 2, NAME,
         synchronizer_terminate::on_error);
 
     // The handler is invoked in the context of the last message receipt.
     protocol_timer::start(period, join_handler);
 
     SUBSCRIBE2(message::version, handle_receive_version, _1, _2);
-    SUBSCRIBE2(verack, handle_receive_verack, _1, _2);
+
+    // Reading waits on the version handler, so the verack is never handled
+    // ahead of it, and the verack handler only sets the handshake event.
+    SUBSCRIBE_INLINE2(verack, handle_receive_verack, _1, _2);
     SEND2(version_factory(), handle_send, _1, version::command);
 }
 
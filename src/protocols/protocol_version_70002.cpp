@@ -19,6 +19,7 @@
 #include <bitcoin/network/protocols/protocol_version_70002.hpp>
 
 #include <cstdint>
+#include <utility>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/p2p.hpp>
@@ -68,7 +69,7 @@ protocol_version_70002::protocol_version_70002(p2p& network,
 
 void protocol_version_70002::start(event_handler handler)
 {
-    protocol_version_31402::start(handler);
+    protocol_version_31402::start(std::move(handler));
 
     SUBSCRIBE2(reject, handle_receive_reject, _1, _2);
 }
@@ -21,6 +21,7 @@
 #define BOOST_BIND_NO_PLACEHOLDERS
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -28,7 +29,9 @@
 #include <memory>
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/block_decoder.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/message_pool.hpp>
 #include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
@@ -46,28 +49,46 @@ static const size_t invalid_payload_dump_size = 1024;
 // payload_buffer_ sizing assumes monotonically increasing size by version.
 // Initialize to pre-witness max payload and let grow to witness as required.
 // The socket owns the single thread on which this channel reads and writes.
-proxy::proxy(threadpool& pool, socket::ptr socket, const settings& settings)
+proxy::proxy(threadpool& pool, socket::ptr socket,
+    priority_dispatcher& dispatch, payload_cache& payloads,
+    const connection_slab::byte_allocator& allocator,
+    memory_governor& governor, const settings& settings)
   : authority_(socket->authority()),
+    governor_(governor),
+    account_(std::allocate_shared<memory_governor::account>(allocator,
+        governor)),
+    payloads_(payloads),
     heading_buffer_(heading::maximum_size()),
     payload_buffer_(heading::maximum_payload_size(settings.protocol_maximum, false)),
+    payload_reserved_(0),
     maximum_payload_(heading::maximum_payload_size(settings.protocol_maximum,
         (settings.services & version::service::node_witness) != 0)),
     socket_(socket),
     stopped_(true),
+    resuming_(false),
+    in_flight_(0),
+    pipeline_depth_(std::max(settings.pipeline_depth, uint32_t(1))),
     protocol_magic_(settings.identifier),
     validate_checksum_(settings.validate_checksum),
+    precheck_work_(settings.proof_of_work_precheck),
     verbose_(settings.verbose),
     version_(settings.protocol_maximum),
-    message_subscriber_(pool),
-    stop_subscriber_(std::make_shared<stop_subscriber>(pool, NAME "_sub")),
-    dispatch_(pool, NAME "_dispatch")
+    message_subscriber_(pool, dispatch, allocator,
+        settings.ordered_relay, pipeline_depth_ > 1,
+        settings.parallel_block_decode, settings.retain_wire_payloads),
+    stop_subscriber_(std::allocate_shared<stop_subscriber>(allocator, pool,
+        NAME "_sub")),
+    sent_(0)
 {
     //LOG_INFO(LOG_NETWORK) << "proxy::proxy";
+    account_payload();
 }
 
+// The account outlives the proxy while payloads it shared are referenced.
 proxy::~proxy() {
     //LOG_INFO(LOG_NETWORK) << "proxy::~proxy";
     BITCOIN_ASSERT_MSG(stopped(), "The channel was not stopped.");
+    account_->release(memory_governor::category::payload, payload_reserved_);
 }
 
 // Properties.
@@ -85,6 +106,10 @@ void proxy::set_negotiated_version(uint32_t value) {
     version_.store(value);
 }
 
+size_t proxy::memory_usage() const {
+    return account_->usage();
+}
+
 // Start sequence.
 // ----------------------------------------------------------------------------
 
@@ -103,7 +128,7 @@ void proxy::start(result_handler handler) {
     handler(error::success);
 
     // Start the read cycle.
-    read_heading();
+    read_heading(shared_from_this());
 }
 
 // Stop subscription.
@@ -116,18 +141,44 @@ void proxy::subscribe_stop(result_handler handler) {
 
 // Read cycle (read continues until stop).
 // ----------------------------------------------------------------------------
+// The reference that keeps the proxy alive is moved from step to step of the
+// cycle, a reference is copied only where a handoff resumes the cycle.
 
-void proxy::read_heading() {
+void proxy::read_heading(ptr&& self) {
     //LOG_INFO(LOG_NETWORK) << "proxy::read_heading()";
     if (stopped())
         return;
 
+    // The idle read buffer is released under memory pressure, the next read
+    // reallocates it at the size of its payload.
+    if (payload_reserved_ != 0 &&
+        governor_.over(memory_governor::category::payload))
+    {
+        payload_buffer_ = data_chunk{};
+        account_payload();
+    }
+
+    // Reading waits under memory pressure only while this connection holds
+    // relay or outbound backlog, which drains without reading. Others, such
+    // as those in handshake, continue.
+    if (account_->backlogged())
+    {
+        governor_.suspend([self = std::move(self)]() mutable
+        {
+            self->read_heading(std::move(self));
+        });
+
+        return;
+    }
+
     async_read(socket_->get(), buffer(heading_buffer_),
-        std::bind(&proxy::handle_read_heading,
-            shared_from_this(), _1, _2));
+        [self = std::move(self)](const boost_code& ec, size_t) mutable
+        {
+            self->handle_read_heading(ec, std::move(self));
+        });
 }
 
-void proxy::handle_read_heading(const boost_code& ec, size_t) {
+void proxy::handle_read_heading(const boost_code& ec, ptr&& self) {
     // LOG_INFO(LOG_NETWORK) << "proxy::handle_read_heading()";
     if (stopped())
         return;
@@ -170,23 +221,29 @@ void proxy::handle_read_heading(const boost_code& ec, size_t) {
         return;
     }
 
-    read_payload(head);
+    read_payload(head, std::move(self));
 }
 
-void proxy::read_payload(const heading& head) {
+void proxy::read_payload(const heading& head, ptr&& self) {
     //LOG_INFO(LOG_NETWORK) << "proxy::read_payload()";
     if (stopped())
         return;
 
-    // This does not cause a reallocation.
+    // This does not cause a reallocation unless the buffer was released.
     payload_buffer_.resize(head.payload_size());
+    account_payload();
 
     async_read(socket_->get(), buffer(payload_buffer_),
-        std::bind(&proxy::handle_read_payload,
-            shared_from_this(), _1, _2, head));
+        [self = std::move(self), head](const boost_code& ec,
+            size_t payload_size) mutable
+        {
+            self->handle_read_payload(ec, payload_size, head,
+                std::move(self));
+        });
 }
 
-void proxy::handle_read_payload(const boost_code& ec, size_t payload_size, const heading& head) {
+void proxy::handle_read_payload(const boost_code& ec, size_t payload_size,
+    const heading& head, ptr&& self) {
     //LOG_INFO(LOG_NETWORK) << "proxy::handle_read_payload()";
     if (stopped())
         return;
@@ -211,18 +268,94 @@ void proxy::handle_read_payload(const boost_code& ec, size_t payload_size, const
         return;
     }
 
+    // Junk blocks cost one header hash, not a decode of the payload.
+    if (precheck_work_ && !block_decoder::check_work(head.type(),
+        payload_buffer_))
+    {
+        LOG_WARNING(LOG_NETWORK)
+            << "Invalid " << head.command() << " payload from [" << authority()
+            << "] insufficient proof of work.";
+        stop(error::invalid_proof_of_work);
+        return;
+    }
+
+    // Without read ahead an owned payload only costs a buffer reallocation,
+    // so a depth of one decodes from the read buffer unless it is retained.
+    const auto type = head.type();
+    const auto hashed = message_subscriber::pipelined(type);
+    const auto pipelined = pipeline_depth_ > 1 && hashed;
+    const auto owned = pipelined || (hashed &&
+        message_subscriber_.retained(type));
+
+    // A transaction already relayed from any channel is dropped before it is
+    // decoded. Blocks and headers are not, as protocols track each request.
+    if (type == message_type::transaction &&
+        payloads_.duplicate(type, head.checksum(), payload_buffer_))
+    {
+        LOG_VERBOSE(LOG_NETWORK)
+            << "Dropped duplicate " << head.command() << " from ["
+            << authority() << "] (" << payload_size << " bytes)";
+
+        signal_activity();
+        read_heading(std::move(self));
+        return;
+    }
+
+    const auto payload = owned ? release_payload() : nullptr;
+
+    if (message_subscriber_.raw(type))
+    {
+        // Only a small message that is also decoded requires a copy.
+        const auto decoded = message_subscriber_.decoded(type);
+        const auto shared = payload ? payload : decoded ?
+            share_payload(data_chunk(payload_buffer_)) : release_payload();
+
+        if (!decoded)
+        {
+            // As with decode, the handoff and this thread both resume.
+            message_subscriber_.relay_raw(head, shared, resumer(self));
+
+            LOG_VERBOSE(LOG_NETWORK)
+                << "Received " << head.command() << " from [" << authority()
+                << "] (" << payload_size << " bytes, raw)";
+
+            signal_activity();
+            resume_read(std::move(self));
+            return;
+        }
+
+        // Reading resumes with the decode of the message.
+        message_subscriber_.relay_raw(head, shared, [](){});
+    }
+
+    if (pipelined)
+    {
+        read_ahead(head, payload, std::move(self));
+        return;
+    }
+
     // Notify subscribers of the new message.
     payload_source source(payload_buffer_);
     payload_stream istream(source);
 
     // Failures are not forwarded to subscribers and channel is stopped below.
-    const auto code = message_subscriber_.load(head.type(), version_, istream);
-    const auto consumed = istream.peek() == std::istream::traits_type::eof();
+    // On success the handoff resumes reading, possibly before this returns.
+    // Pipelined types cache hashes of the payload and fail on trailing bytes,
+    // and an owned payload is retained by its message for forwarding.
+    const auto code = payload ?
+        message_subscriber_.decode(type, version_, payload, resumer(self)) :
+        hashed ?
+        message_subscriber_.decode(type, version_, payload_buffer_,
+            resumer(self)) :
+        message_subscriber_.load(type, version_, istream, resumer(self));
+    const auto consumed = hashed ||
+        istream.peek() == std::istream::traits_type::eof();
+    const auto& bytes = payload ? *payload : payload_buffer_;
 
     if (verbose_ && code)
     {
         const auto size = std::min(payload_size, invalid_payload_dump_size);
-        const auto begin = payload_buffer_.begin();
+        const auto begin = bytes.begin();
 
         LOG_VERBOSE(LOG_NETWORK)
             << "Invalid payload from [" << authority() << "] "
@@ -254,25 +387,209 @@ void proxy::handle_read_payload(const boost_code& ec, size_t payload_size, const
         << "] (" << payload_size << " bytes)";
 
     signal_activity();
-    read_heading();
+    resume_read(std::move(self));
+}
+
+// The handoff holds its own reference, as it may resume after this thread.
+priority_dispatcher::job proxy::resumer(const ptr& self) {
+    return [self = self]() mutable
+    {
+        self->resume_read(std::move(self));
+    };
+}
+
+// The next read requires both release of the payload buffer by this thread
+// and the handoff of the message to subscribers, whichever completes last.
+void proxy::resume_read(ptr&& self) {
+    if (!resuming_.exchange(true))
+        return;
+
+    resuming_ = false;
+    read_heading(std::move(self));
+}
+
+// The payload is shared with handlers, the moved-from buffer is reallocated
+// by the next read.
+message_subscriber::payload_ptr proxy::release_payload() {
+    auto payload = share_payload(std::move(payload_buffer_));
+    payload_buffer_ = data_chunk{};
+    account_payload();
+    return payload;
+}
+
+// A shared payload is accounted as relayed until its last reference is gone.
+// It is allocated from the heap, as the connection slab only grows.
+message_subscriber::payload_ptr proxy::share_payload(data_chunk&& payload) {
+    const auto size = payload.capacity();
+    const auto account = account_;
+    account->reserve(memory_governor::category::relay, size);
+
+    const auto release = [account, size](const data_chunk* instance)
+    {
+        delete instance;
+        account->release(memory_governor::category::relay, size);
+    };
+
+    return message_subscriber::payload_ptr(
+        new data_chunk(std::move(payload)), release);
+}
+
+// The read buffer is accounted by capacity, as it is retained between reads.
+void proxy::account_payload() {
+    const auto capacity = payload_buffer_.capacity();
+
+    if (capacity > payload_reserved_)
+        account_->reserve(memory_governor::category::payload,
+            capacity - payload_reserved_);
+    else if (capacity < payload_reserved_)
+        account_->release(memory_governor::category::payload,
+            payload_reserved_ - capacity);
+
+    payload_reserved_ = capacity;
+}
+
+// With a depth above one, blocks and transactions are decoded and handled
+// behind the reader, in order, while the next message is read into a new
+// buffer. Reading pauses once pipeline depth messages are in flight and
+// resumes as one completes.
+void proxy::read_ahead(const heading& head,
+    message_subscriber::payload_ptr payload, ptr&& self) {
+    // Counted before handoff, as the completion may precede the return.
+    const auto in_flight = ++in_flight_;
+
+    message_subscriber_.load(head.type(), version_, std::move(payload),
+        [self, head](const code& ec) mutable
+        {
+            self->handle_read_ahead(ec, head, std::move(self));
+        });
+
+    LOG_VERBOSE(LOG_NETWORK)
+        << "Received " << head.command() << " from [" << authority()
+        << "] (" << head.payload_size() << " bytes)";
+
+    signal_activity();
+
+    if (in_flight < pipeline_depth_)
+        read_heading(std::move(self));
+}
+
+void proxy::handle_read_ahead(const code& ec, const heading& head,
+    ptr&& self) {
+    if (ec && !stopped())
+    {
+        LOG_WARNING(LOG_NETWORK)
+            << "Invalid " << head.command() << " payload from [" << authority()
+            << "] " << ec.message();
+        stop(ec);
+    }
+
+    // Only the completion that unblocks a full pipeline resumes reading.
+    if (in_flight_-- == pipeline_depth_)
+        read_heading(std::move(self));
 }
 
 // Message send sequence.
 // ----------------------------------------------------------------------------
 
-void proxy::do_send(command_ptr command, payload_ptr payload, result_handler handler) {
-    // LOG_INFO(LOG_NETWORK) << "proxy::do_send()";
+// Small buffers are recycled, larger ones would hold memory in the pools.
+static const size_t recycled_buffer_maximum = 4096;
 
-    async_write(socket_->get(), buffer(*payload),
-        std::bind(&proxy::handle_send,
-            shared_from_this(), _1, _2, command, payload, handler));
+proxy::buffer_ptr proxy::make_buffer(size_t size)
+{
+    const auto buffer = size <= recycled_buffer_maximum ?
+        message_pool<data_chunk>::acquire() : std::make_shared<data_chunk>();
+    buffer->resize(size);
+    return buffer;
 }
 
-void proxy::handle_send(const boost_code& ec, size_t, command_ptr command, payload_ptr payload, result_handler handler) {
-    // LOG_INFO(LOG_NETWORK) << "proxy::handle_send()";
+void proxy::write_heading(data_chunk& buffer, const heading& head)
+{
+    BITCOIN_ASSERT(buffer.size() >= heading::satoshi_fixed_size());
+    auto sink = make_unsafe_serializer(buffer.begin());
+    head.to_data(sink);
+}
+
+// Sequential writes are required because a write may occur in multiple
+// asynchronous steps invoked on different threads. The queue retains its
+// capacity, so a send does not allocate once the queue is warm. A forwarded
+// wire payload is accounted as relayed by the channel that received it.
+void proxy::enqueue(const std::string& command, buffer_ptr data,
+    wire_payload::ptr wire, send_handler&& handler)
+{
+    account_->reserve(memory_governor::category::outbound, data->size());
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(send_mutex_);
+
+    sends_.push_back({ &command, data, wire, std::move(handler) });
+
+    // A pending write continues with the queue.
+    if (sends_.size() - sent_ == 1)
+        write_next(shared_from_this());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The heading and any forwarded payload are written as one buffer sequence.
+// This must be called under send_mutex_.
+void proxy::write_next(ptr&& self)
+{
+    const auto& next = sends_[sent_];
+    const std::array<const_buffer, 2> buffers
+    {
+        {
+            buffer(*next.data),
+            next.wire ? buffer(next.wire->payload()) : const_buffer()
+        }
+    };
+
+    async_write(socket_->get(), buffers, write_handler{ std::move(self) });
+}
+
+void proxy::handle_write(const boost_code& ec, const ptr& self)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    send_mutex_.lock();
 
-    dispatch_.unlock();
-    const auto size = payload->size();
+    auto& sent = sends_[sent_++];
+    const auto command = sent.command;
+    const auto handler = std::move(sent.handler);
+    const auto queued = sent.data->size();
+    const auto size = queued + (sent.wire ? sent.wire->payload().size() : 0);
+
+    // Buffers are released to their pool as soon as written.
+    sent.data.reset();
+    sent.wire.reset();
+
+    if (sent_ == sends_.size())
+    {
+        sends_.clear();
+        sent_ = 0;
+    }
+    else
+    {
+        // Written entries are dropped once they are half of the queue, so a
+        // queue that is refilled before it drains keeps its capacity.
+        if (2 * sent_ >= sends_.size())
+        {
+            sends_.erase(sends_.begin(), sends_.begin() + sent_);
+            sent_ = 0;
+        }
+
+        // The reference is copied, this completion continues below.
+        write_next(ptr(self));
+    }
+
+    send_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    account_->release(memory_governor::category::outbound, queued);
+    complete_send(ec, *command, size, handler);
+}
+
+void proxy::complete_send(const boost_code& ec, const std::string& command,
+    size_t size, const send_handler& handler) {
     const auto error = code(error::boost_to_error_code(ec));
 
     if (stopped())
@@ -284,20 +601,50 @@ void proxy::handle_send(const boost_code& ec, size_t, command_ptr command, paylo
     if (error)
     {
         LOG_DEBUG(LOG_NETWORK)
-            << "Failure sending " << *command << " to [" << authority()
+            << "Failure sending " << command << " to [" << authority()
             << "] (" << size << " bytes) " << error.message();
         stop(error);
         handler(error);
         return;
     }
 
-    LOG_VERBOSE(LOG_NETWORK)
-        << "Sent " << *command << " to [" << authority() << "] (" << size
-        << " bytes)";
+    // The record is not formatted per send unless verbose.
+    if (verbose_)
+    {
+        LOG_VERBOSE(LOG_NETWORK)
+            << "Sent " << command << " to [" << authority() << "] (" << size
+            << " bytes)";
+    }
 
     handler(error);
 }
 
+// Write memory.
+// ----------------------------------------------------------------------------
+
+proxy::write_memory::write_memory()
+  : used_(false)
+{
+}
+
+// Composed write steps allocate one at a time, each freed before the next.
+void* proxy::write_memory::allocate(size_t size)
+{
+    if (used_ || size > sizeof(storage_))
+        return ::operator new(size);
+
+    used_ = true;
+    return &storage_;
+}
+
+void proxy::write_memory::deallocate(void* block)
+{
+    if (block == &storage_)
+        used_ = false;
+    else
+        ::operator delete(block);
+}
+
 // Stop sequence.
 // ----------------------------------------------------------------------------
 
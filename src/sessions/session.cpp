@@ -86,6 +86,11 @@ bool session::blacklisted(const authority& authority) const
     return std::any_of(list.begin(), list.end(), ip_compare);
 }
 
+memory_governor::pressure session::memory_pressure() const
+{
+    return network_.governor().level();
+}
+
 bool session::stopped() const
 {
     return stopped_;
@@ -101,12 +106,16 @@ bool session::stopped(const code& ec) const
 
 acceptor::ptr session::create_acceptor()
 {
-    return std::make_shared<acceptor>(pool_, settings_);
+    return std::make_shared<acceptor>(pool_, network_.timers(),
+        network_.lanes(), network_.payloads(), network_.slab(),
+        network_.governor(), settings_);
 }
 
 connector::ptr session::create_connector()
 {
-    return std::make_shared<connector>(pool_, settings_);
+    return std::make_shared<connector>(pool_, network_.timers(),
+        network_.lanes(), network_.payloads(), network_.slab(),
+        network_.governor(), settings_);
 }
 
 // Pending connect.
@@ -110,6 +110,16 @@ void session_inbound::start_accept(const code&)
         return;
     }
 
+    // Connections wait in the listen backlog rather than being accepted and
+    // built only to be dropped. Open connections read until evicted.
+    if (memory_pressure() >= memory_governor::pressure::refuse_inbound)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Deferred inbound connections due to memory budget.";
+        dispatch_delayed(settings_.connect_timeout(), BIND1(start_accept, _1));
+        return;
+    }
+
     // ACCEPT THE NEXT INCOMING CONNECTION
     acceptor_->accept(BIND2(handle_accept, _1, _2));
 }
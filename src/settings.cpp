@@ -30,6 +30,10 @@ using namespace bc::message;
 // Common default values (no settings context).
 settings::settings()
   : threads(0),
+    thread_maximum(0),
+    handler_threads(0),
+    handler_queue_limit(1000),
+    numa_placement(false),
     protocol_maximum(version::level::maximum),
     protocol_minimum(version::level::minimum),
     services(version::service::none),
@@ -39,6 +43,17 @@ settings::settings()
     invalid_services(176),
 #endif    
     relay_transactions(true),
+    ordered_relay(false),
+    pipeline_depth(1),
+    parallel_block_decode(false),
+    proof_of_work_precheck(false),
+    payload_cache_capacity(0),
+    retain_wire_payloads(false),
+    connection_slab_size(0),
+    memory_budget_megabytes(0),
+    memory_payload_megabytes(0),
+    memory_outbound_megabytes(0),
+    memory_relay_megabytes(0),
     validate_checksum(false),
     inbound_connections(0),
     outbound_connections(8),
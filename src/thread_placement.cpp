@@ -0,0 +1,352 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/thread_placement.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace libbitcoin {
+namespace network {
+
+static const auto numa_directory = "/sys/devices/system/node";
+static const std::string node_prefix = "node";
+
+// A busy or undersized pool cannot take one job on every thread, idle threads
+// take theirs within milliseconds.
+static const auto bind_timeout = std::chrono::seconds(1);
+
+// Set once the thread has been bound (or its binding has been attempted).
+static thread_local bool placed_thread = false;
+
+// The character classification functions require unsigned char values.
+static bool is_digit(unsigned char character)
+{
+    return std::isdigit(character) != 0;
+}
+
+static bool is_space(unsigned char character)
+{
+    return std::isspace(character) != 0;
+}
+
+// Returns false if the text is not a non-empty decimal number.
+static bool to_number(const std::string& text, uint32_t& out)
+{
+    if (text.empty() || text.size() > 9 ||
+        !std::all_of(text.begin(), text.end(), is_digit))
+        return false;
+
+    out = static_cast<uint32_t>(std::stoul(text));
+    return true;
+}
+
+thread_placement::processors thread_placement::parse(const std::string& list)
+{
+    processors cpus;
+    std::string range;
+    std::istringstream stream(list);
+
+    while (std::getline(stream, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), is_space),
+            range.end());
+
+        uint32_t first;
+        uint32_t last;
+        const auto dash = range.find('-');
+
+        if (dash == std::string::npos)
+        {
+            if (!to_number(range, first))
+                return{};
+
+            last = first;
+        }
+        else if (!to_number(range.substr(0, dash), first) ||
+            !to_number(range.substr(dash + 1), last) || last < first)
+        {
+            return{};
+        }
+
+        for (auto cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::vector<thread_placement::processors> thread_placement::numa_nodes()
+{
+    using namespace boost::filesystem;
+    std::map<uint32_t, processors> nodes;
+    boost::system::error_code ec;
+
+    for (directory_iterator it(numa_directory, ec), end; !ec && it != end;
+        it.increment(ec))
+    {
+        uint32_t node;
+        const auto name = it->path().filename().string();
+
+        if (name.compare(0, node_prefix.size(), node_prefix) != 0 ||
+            !to_number(name.substr(node_prefix.size()), node))
+            continue;
+
+        std::string list;
+        std::ifstream file((it->path() / "cpulist").string());
+
+        if (std::getline(file, list))
+        {
+            auto cpus = parse(list);
+
+            // Memory-only nodes have no processors.
+            if (!cpus.empty())
+                nodes.emplace(node, std::move(cpus));
+        }
+    }
+
+    std::vector<processors> out;
+    out.reserve(nodes.size());
+
+    for (auto& node: nodes)
+        out.push_back(std::move(node.second));
+
+    return out;
+}
+
+bool thread_placement::bind(const processors& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (const auto cpu: cpus)
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+
+    return !cpus.empty() &&
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+bool thread_placement::placed()
+{
+    return placed_thread;
+}
+
+thread_placement::thread_placement(const processors& allowed, bool numa)
+{
+    auto sorted = allowed;
+    std::sort(sorted.begin(), sorted.end());
+
+    if (numa)
+    {
+        for (const auto& node: numa_nodes())
+        {
+            if (sorted.empty())
+            {
+                sets_.push_back(node);
+                continue;
+            }
+
+            processors set;
+            std::set_intersection(node.begin(), node.end(), sorted.begin(),
+                sorted.end(), std::back_inserter(set));
+
+            if (!set.empty())
+                sets_.push_back(std::move(set));
+        }
+
+        // A single node gains nothing over the plain processor set.
+        if (sets_.size() == 1)
+            sets_.clear();
+    }
+
+    if (sets_.empty() && !sorted.empty())
+        sets_.push_back(std::move(sorted));
+}
+
+bool thread_placement::empty() const
+{
+    return sets_.empty();
+}
+
+const thread_placement::processors& thread_placement::assignment(
+    size_t ordinal) const
+{
+    static const processors none;
+    return sets_.empty() ? none : sets_[ordinal % sets_.size()];
+}
+
+// Each thread takes one job and holds it until all threads have taken one,
+// which ensures that every thread of the pool is bound exactly once. The
+// state is shared with the jobs, as they may outlive an abandoned wait.
+bool thread_placement::apply(threadpool& pool, size_t threads,
+    size_t first) const
+{
+    if (sets_.empty() || threads == 0)
+        return true;
+
+    if (pool.size() < threads)
+        return false;
+
+    struct barrier
+    {
+        std::vector<processors> assignments;
+        std::mutex mutex;
+        std::condition_variable condition;
+        size_t started;
+        size_t bound;
+        bool abandoned;
+    };
+
+    const auto state = std::make_shared<barrier>();
+    state->started = 0;
+    state->bound = 0;
+    state->abandoned = false;
+
+    for (size_t thread = 0; thread < threads; ++thread)
+        state->assignments.push_back(assignment(first + thread));
+
+    for (size_t thread = 0; thread < threads; ++thread)
+    {
+        pool.service().post([state, threads]()
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+
+            if (state->abandoned)
+                return;
+
+            const auto& cpus = state->assignments[state->started++];
+            lock.unlock();
+            placed_thread = true;
+
+            if (!bind(cpus))
+                LOG_WARNING(LOG_NETWORK)
+                    << "Failed to set network thread processor affinity.";
+
+            lock.lock();
+            ++state->bound;
+            state->condition.notify_all();
+            state->condition.wait(lock, [&]()
+            {
+                return state->bound == threads || state->abandoned;
+            });
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+
+    if (state->condition.wait_for(lock, bind_timeout, [&]()
+        {
+            return state->bound == threads;
+        }))
+        return true;
+
+    // Release the bound threads, jobs not yet started will not bind.
+    state->abandoned = true;
+    state->condition.notify_all();
+    return false;
+}
+
+// The pool offers no way to target a thread, so one job is posted for each
+// thread. A placed thread that takes one holds it until the new thread has
+// taken another and bound itself, so the new thread is never starved of a
+// job by threads that would otherwise take them all.
+void thread_placement::place(threadpool& pool, size_t ordinal) const
+{
+    if (sets_.empty())
+        return;
+
+    struct barrier
+    {
+        processors cpus;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool bound;
+        bool abandoned;
+    };
+
+    const auto state = std::make_shared<barrier>();
+    state->cpus = assignment(ordinal);
+    state->bound = false;
+    state->abandoned = false;
+
+    for (size_t thread = 0; thread < pool.size(); ++thread)
+    {
+        pool.service().post([state]()
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+
+            if (state->bound)
+                return;
+
+            if (!placed_thread)
+            {
+                placed_thread = true;
+
+                if (!bind(state->cpus))
+                    LOG_WARNING(LOG_NETWORK)
+                        << "Failed to set network thread processor affinity.";
+
+                state->bound = true;
+                state->condition.notify_all();
+                return;
+            }
+
+            if (state->condition.wait_for(lock, bind_timeout, [&]()
+                {
+                    return state->bound || state->abandoned;
+                }))
+                return;
+
+            // Release the other held threads, the new thread may still bind.
+            state->abandoned = true;
+            state->condition.notify_all();
+            LOG_WARNING(LOG_NETWORK)
+                << "Failed to place a new network thread.";
+        });
+    }
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,275 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/thread_scaler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::placeholders;
+using namespace std::chrono;
+
+typedef priority_dispatcher::priority priority;
+
+// Grow when queued jobs exceed this many per active thread.
+static const size_t grow_depth = 4;
+
+// Grow when scheduling lag exceeds this, shrink only when below the second.
+static const int64_t grow_lag_microseconds = 50000;
+static const int64_t shrink_lag_microseconds = 5000;
+
+// Grow quickly under load, shrink slowly when idle (hysteresis).
+static const size_t grow_samples = 2;
+static const size_t shrink_samples = 30;
+
+static int64_t now_microseconds()
+{
+    return duration_cast<microseconds>(
+        asio::steady_clock::now().time_since_epoch()).count();
+}
+
+thread_scaler::thread_scaler(threadpool& pool, timer_wheel& timers,
+    priority_dispatcher& dispatch, const thread_placement& placement,
+    size_t first, size_t minimum, size_t maximum,
+    const asio::duration& period)
+  : pool_(pool),
+    dispatch_(dispatch),
+    placement_(placement),
+    first_(first),
+    minimum_(std::max(minimum, size_t(1))),
+    maximum_(std::max(maximum, minimum_)),
+    timer_(timers, period),
+    active_(minimum_),
+    resizes_(0),
+    probing_(false),
+    probe_posted_(0),
+    lag_(0),
+    busy_samples_(0),
+    idle_samples_(0),
+    stopped_(true),
+    parked_(0),
+    wakes_(0)
+{
+}
+
+void thread_scaler::start()
+{
+    if (maximum_ == minimum_)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    // All threads were joined before restart.
+    stopped_ = false;
+    parked_ = 0;
+    wakes_ = 0;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    active_ = minimum_;
+    probing_ = false;
+    lag_ = 0;
+    busy_samples_ = 0;
+    idle_samples_ = 0;
+    dispatch_.set_concurrency(minimum_);
+
+    timer_.start(
+        std::bind(&thread_scaler::sample,
+            this, _1));
+}
+
+void thread_scaler::stop()
+{
+    timer_.stop();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    stopped_ = true;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    condition_.notify_all();
+}
+
+size_t thread_scaler::size() const
+{
+    return active_;
+}
+
+size_t thread_scaler::resizes() const
+{
+    return resizes_;
+}
+
+// Sampling.
+// ----------------------------------------------------------------------------
+
+void thread_scaler::sample(const code& ec)
+{
+    if (ec)
+        return;
+
+    // An outstanding probe is still waiting for a thread, count that wait.
+    auto lag = lag_.load();
+
+    if (probing_)
+        lag = std::max(lag, now_microseconds() - probe_posted_);
+    else
+        probe();
+
+    const auto active = active_.load();
+    const auto depth = dispatch_.size(priority::control) +
+        dispatch_.size(priority::bulk);
+
+    const auto busy = depth > active * grow_depth ||
+        lag > grow_lag_microseconds;
+    const auto idle = depth == 0 && lag < shrink_lag_microseconds;
+
+    busy_samples_ = busy ? busy_samples_ + 1 : 0;
+    idle_samples_ = idle ? idle_samples_ + 1 : 0;
+
+    if (busy_samples_ >= grow_samples && active < maximum_)
+        grow();
+    else if (idle_samples_ >= shrink_samples && active > minimum_)
+        shrink();
+
+    timer_.start(
+        std::bind(&thread_scaler::sample,
+            this, _1));
+}
+
+// The lag is the time a job posted to the pool waits for a thread.
+void thread_scaler::probe()
+{
+    probing_ = true;
+    const auto posted = now_microseconds();
+    probe_posted_ = posted;
+
+    pool_.service().post([this, posted]()
+    {
+        lag_ = now_microseconds() - posted;
+        probing_ = false;
+    });
+}
+
+// Resizing.
+// ----------------------------------------------------------------------------
+
+void thread_scaler::grow()
+{
+    auto spawn = false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    if (stopped_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    if (parked_ > 0)
+    {
+        --parked_;
+        ++wakes_;
+    }
+    else
+    {
+        spawn = true;
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (spawn)
+    {
+        pool_.spawn(1, thread_priority::normal);
+        placement_.place(pool_, first_ + pool_.size() - 1);
+    }
+    else
+        condition_.notify_one();
+
+    const auto active = ++active_;
+    ++resizes_;
+    busy_samples_ = 0;
+    dispatch_.set_concurrency(active);
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Handler threads increased to (" << active << ").";
+}
+
+void thread_scaler::shrink()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    if (stopped_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    ++parked_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    pool_.service().post(
+        std::bind(&thread_scaler::park,
+            this));
+
+    const auto active = --active_;
+    ++resizes_;
+    idle_samples_ = 0;
+    dispatch_.set_concurrency(active);
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Handler threads decreased to (" << active << ").";
+}
+
+// Hold the pool thread that takes this job until woken or stopped.
+void thread_scaler::park()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return stopped_ || wakes_ > 0; });
+
+    if (wakes_ > 0)
+        --wakes_;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,334 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/timer_wheel.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::placeholders;
+
+// The furthest expiry representable by the wheel, later timers are clamped.
+static const uint64_t maximum_ticks = (uint64_t(1) << (6 * 4)) - 1;
+
+timer_wheel::timer_wheel(threadpool& pool, const asio::duration& resolution,
+    size_t shards)
+  : resolution_(std::max(resolution, asio::duration(asio::milliseconds(1)))),
+    next_(0),
+    now_(0),
+    stopped_(true),
+    epoch_(asio::steady_clock::now()),
+    ticker_(std::make_shared<deadline>(pool, resolution_))
+{
+    shards_.reserve(std::max(shards, size_t(1)));
+
+    for (size_t shard = 0; shard < shards_.capacity(); ++shard)
+        shards_.push_back(std::make_shared<timer_wheel::shard>(resolution_));
+}
+
+// Tick sequence.
+// ----------------------------------------------------------------------------
+
+void timer_wheel::start()
+{
+    if (!stopped_.exchange(false))
+        return;
+
+    // Restarting does not rewind the wheel, shards only move forward.
+    epoch_.store(asio::steady_clock::now() - resolution_ * now_.load());
+    tick();
+}
+
+void timer_wheel::stop()
+{
+    stopped_ = true;
+    ticker_->stop();
+}
+
+void timer_wheel::tick()
+{
+    if (stopped_)
+        return;
+
+    ticker_->start(
+        std::bind(&timer_wheel::handle_tick,
+            this, _1));
+}
+
+// The deadline is restarted relative to now, so compute elapsed ticks from
+// the epoch and advance the shards over any that were skipped due to drift.
+void timer_wheel::handle_tick(const code& ec)
+{
+    if (stopped_ || ec)
+        return;
+
+    const auto elapsed = asio::steady_clock::now() - epoch_.load();
+    advance(static_cast<uint64_t>(elapsed / resolution_));
+    tick();
+}
+
+// Shards pass ticks with nothing due under one lock, each stopping at its
+// first tick with timers due, so the earliest of these is the next tick of
+// the wheel. A shard that has passed this tick has nothing due before it.
+void timer_wheel::advance(uint64_t target)
+{
+    while (now_.load() < target)
+    {
+        auto tick = target;
+        for (const auto& shard: shards_)
+            tick = std::min(tick, shard->advance(tick));
+
+        now_.store(tick, std::memory_order_relaxed);
+
+        for (const auto& shard: shards_)
+            shard->expire(tick, expired_);
+
+        // Handlers are invoked outside of shard locks, so they may restart.
+        for (auto& handle: expired_)
+            handle(error::success);
+
+        expired_.clear();
+    }
+}
+
+// Properties.
+// ----------------------------------------------------------------------------
+
+uint64_t timer_wheel::now() const
+{
+    return now_.load(std::memory_order_relaxed);
+}
+
+const asio::duration& timer_wheel::resolution() const
+{
+    return resolution_;
+}
+
+timer_wheel::shard_ptr timer_wheel::next_shard()
+{
+    return shards_[next_++ % shards_.size()];
+}
+
+// Timer.
+// ----------------------------------------------------------------------------
+
+timer_wheel::timer::timer(timer_wheel& wheel, const asio::duration& duration)
+  : shard_(wheel.next_shard()),
+    duration_(duration),
+    previous_(nullptr),
+    next_(nullptr),
+    expiry_(0),
+    linked_(false)
+{
+}
+
+timer_wheel::timer::~timer()
+{
+    stop();
+}
+
+void timer_wheel::timer::start(handler handle)
+{
+    start(std::move(handle), duration_);
+}
+
+// Replaced handlers are destroyed after the shard lock is released, as they
+// may hold the last reference to the owner of this timer.
+void timer_wheel::timer::start(handler handle, const asio::duration& duration)
+{
+    handler replaced;
+    shard_->schedule(*this, duration, std::move(handle), replaced);
+}
+
+void timer_wheel::timer::stop()
+{
+    handler released;
+    shard_->cancel(*this, released);
+}
+
+// Shard.
+// ----------------------------------------------------------------------------
+
+timer_wheel::shard::shard(const asio::duration& resolution)
+  : resolution_(resolution),
+    current_(0)
+{
+    for (auto& level: levels_)
+        level.fill(nullptr);
+}
+
+uint64_t timer_wheel::shard::to_ticks(const asio::duration& duration) const
+{
+    if (duration <= asio::duration::zero())
+        return 1;
+
+    const auto count = static_cast<uint64_t>(
+        (duration + resolution_ - asio::duration(1)) / resolution_);
+
+    return std::min(std::max(count, uint64_t(1)), maximum_ticks);
+}
+
+void timer_wheel::shard::schedule(timer& instance,
+    const asio::duration& duration, handler&& handle, handler& out_replaced)
+{
+    const auto ticks = to_ticks(duration);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (instance.linked_)
+        unlink(instance);
+
+    out_replaced = std::move(instance.handler_);
+    instance.duration_ = duration;
+    instance.handler_ = std::move(handle);
+    instance.expiry_ = current_ + ticks;
+    link(instance);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void timer_wheel::shard::cancel(timer& instance, handler& out_released)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (instance.linked_)
+        unlink(instance);
+
+    out_released = std::move(instance.handler_);
+    instance.handler_ = nullptr;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The timers due on the returned tick remain linked until expired, and a
+// timer started meanwhile is never due on it, so the shard waits there.
+uint64_t timer_wheel::shard::advance(uint64_t target)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    while (levels_[0][current_ & (slots - 1)] == nullptr && current_ < target)
+    {
+        const auto tick = ++current_;
+
+        // Redistribute the next higher level slot each time a level wraps.
+        for (size_t depth = 1; depth < levels; ++depth)
+        {
+            const auto shift = slot_bits * (depth - 1);
+            if (((tick >> shift) & (slots - 1)) != 0)
+                break;
+
+            cascade(depth, (tick >> (shift + slot_bits)) & (slots - 1));
+        }
+    }
+
+    return current_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void timer_wheel::shard::expire(uint64_t tick, handlers& out_expired)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (tick != current_)
+        return;
+
+    auto& slot = levels_[0][tick & (slots - 1)];
+
+    while (slot != nullptr)
+    {
+        auto& instance = *slot;
+        unlink(instance);
+        out_expired.push_back(std::move(instance.handler_));
+        instance.handler_ = nullptr;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private, requires exclusive lock.
+void timer_wheel::shard::cascade(size_t depth, size_t index)
+{
+    auto instance = levels_[depth][index];
+    levels_[depth][index] = nullptr;
+
+    while (instance != nullptr)
+    {
+        const auto next = instance->next_;
+        instance->linked_ = false;
+        link(*instance);
+        instance = next;
+    }
+}
+
+// private, requires exclusive lock.
+void timer_wheel::shard::link(timer& instance)
+{
+    // A cascaded timer may be due on the current tick, which is not yet run.
+    BITCOIN_ASSERT(instance.expiry_ >= current_);
+    const auto delta = instance.expiry_ - current_;
+
+    // Select the lowest level that can resolve the remaining delta.
+    size_t depth = 0;
+    while (depth + 1 < levels &&
+        delta >= (uint64_t(1) << (slot_bits * (depth + 1))))
+        ++depth;
+
+    const auto index = (instance.expiry_ >> (slot_bits * depth)) &
+        (slots - 1);
+
+    // The previous link addresses the slot head or the prior timer's next.
+    auto& head = levels_[depth][index];
+    instance.next_ = head;
+    instance.previous_ = &head;
+
+    if (head != nullptr)
+        head->previous_ = &instance.next_;
+
+    head = &instance;
+    instance.linked_ = true;
+}
+
+// private, requires exclusive lock.
+void timer_wheel::shard::unlink(timer& instance)
+{
+    *instance.previous_ = instance.next_;
+
+    if (instance.next_ != nullptr)
+        instance.next_->previous_ = instance.previous_;
+
+    instance.previous_ = nullptr;
+    instance.next_ = nullptr;
+    instance.linked_ = false;
+}
+
+} // namespace network
+} // namespace libbitcoin
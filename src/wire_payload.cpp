@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/wire_payload.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+wire_payload::wire_payload(payload_ptr payload)
+  : payload_(payload),
+    portable_(false),
+    checksum_(0)
+{
+}
+
+const data_chunk& wire_payload::payload() const
+{
+    return *payload_;
+}
+
+// Computed on first forward only, so unforwarded messages cost nothing.
+uint32_t wire_payload::checksum() const
+{
+    std::call_once(once_, [this]()
+    {
+        checksum_ = bitcoin_checksum(*payload_);
+    });
+
+    return checksum_;
+}
+
+bool wire_payload::portable() const
+{
+    return portable_;
+}
+
+void wire_payload::set_portable(bool value)
+{
+    portable_ = value;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+// This binary replaces the global operator new, so it is kept apart from the
+// other tests. Allocations of all threads are counted and forwarded, as a
+// send completes on a network thread.
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    const auto block = std::malloc(size == 0 ? 1 : size);
+
+    if (block == nullptr)
+        throw std::bad_alloc();
+
+    return block;
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+    std::free(block);
+}
+
+static const size_t bursts = 100;
+static const size_t burst = 8;
+
+// A proxy without channel timers, only its send sequence is used.
+class test_proxy
+  : public proxy
+{
+public:
+    test_proxy(threadpool& pool, socket::ptr socket,
+        priority_dispatcher& dispatch, payload_cache& payloads,
+        memory_governor& governor, const network::settings& settings)
+      : proxy(pool, socket, dispatch, payloads,
+            connection_slab::byte_allocator(), governor, settings)
+    {
+    }
+
+protected:
+    void signal_activity() override
+    {
+    }
+
+    void handle_stopping() override
+    {
+    }
+};
+
+// Sends bursts of pings from the calling thread, each burst queued behind
+// its first write, and waits for the completion of each burst. Returns the
+// number of failed sends.
+static size_t send_bursts(proxy& channel, const ping& message)
+{
+    std::atomic<size_t> completed(0);
+    std::atomic<size_t> failed(0);
+
+    for (size_t count = 0; count < bursts; ++count)
+    {
+        completed = 0;
+
+        for (size_t send = 0; send < burst; ++send)
+            channel.send(message, [&completed, &failed](const code& ec)
+            {
+                failed += ec ? 1 : 0;
+                ++completed;
+            });
+
+        while (completed.load() != burst)
+            std::this_thread::yield();
+    }
+
+    return failed.load();
+}
+
+BOOST_AUTO_TEST_SUITE(proxy_allocation_tests)
+
+BOOST_AUTO_TEST_CASE(proxy__send__small_messages_across_threads__no_allocation)
+{
+    threadpool pool;
+    pool.spawn(2);
+    priority_dispatcher dispatch(pool, 2, 0);
+    payload_cache payloads(0);
+    memory_governor governor(0);
+    const network::settings settings;
+    const ping message(42);
+    const auto size = heading::satoshi_fixed_size() +
+        message.serialized_size(settings.protocol_maximum);
+
+    // A local socket pair, the peer end is drained by its own thread.
+    asio::acceptor acceptor(pool.service(),
+        asio::endpoint(asio::address::from_string("127.0.0.1"), 0));
+    const auto socket = std::make_shared<bc::socket>(pool);
+    socket->get().connect(acceptor.local_endpoint());
+    asio::socket peer(pool.service());
+    acceptor.accept(peer);
+
+    std::thread drain([&peer, size]()
+    {
+        std::array<uint8_t, 4096> sink;
+        auto remaining = 2 * bursts * burst * size;
+
+        while (remaining != 0)
+            remaining -= peer.read_some(boost::asio::buffer(sink));
+    });
+
+    const auto channel = std::make_shared<test_proxy>(pool, socket, dispatch,
+        payloads, governor, settings);
+
+    // The proxy reads as a channel does, though the peer does not send.
+    channel->start([](const code& ec)
+    {
+        BOOST_REQUIRE(!ec);
+    });
+
+    // Sends come from a thread other than the network threads, so buffers
+    // and control blocks are released by threads that did not acquire them.
+    // The first pass warms the pools of the thread, the send queue and the
+    // write memory of the proxy.
+    size_t failed = 0;
+    size_t allocated = 0;
+    std::thread sender([&]()
+    {
+        failed += send_bursts(*channel, message);
+        const auto before = allocations.load();
+        failed += send_bursts(*channel, message);
+        allocated = allocations.load() - before;
+    });
+
+    sender.join();
+    drain.join();
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+
+    BOOST_REQUIRE_EQUAL(failed, 0u);
+    BOOST_REQUIRE_EQUAL(allocated, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TEST_BENCH_BENCH_HPP
+#define LIBBITCOIN_NETWORK_TEST_BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace libbitcoin {
+namespace network {
+namespace bench {
+
+typedef std::chrono::steady_clock clock;
+
+/// A benchmark function, registered by name (see BENCHMARK).
+typedef void (*function)();
+
+/// Register a benchmark, invoked by main in name order.
+struct registrar
+{
+    registrar(const char* name, function body);
+};
+
+/// Print the time per operation of a measured case.
+void report(const std::string& name, size_t operations,
+    const clock::duration& elapsed);
+
+/// Print a measured quantity that is not a time per operation.
+void report(const std::string& name, const std::string& value);
+
+/// The elapsed time of a single invocation of the body.
+template <typename Body>
+clock::duration time(Body&& body)
+{
+    const auto start = clock::now();
+    body();
+    return clock::now() - start;
+}
+
+/// Time operations invocations of the body and report the time of each.
+template <typename Body>
+void measure(const std::string& name, size_t operations, Body&& body)
+{
+    const auto elapsed = time([&]()
+    {
+        for (size_t operation = 0; operation < operations; ++operation)
+            body(operation);
+    });
+
+    report(name, operations, elapsed);
+}
+
+} // namespace bench
+} // namespace network
+} // namespace libbitcoin
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static const libbitcoin::network::bench::registrar \
+        name##_registrar(#name, &name); \
+    static void name()
+
+#endif
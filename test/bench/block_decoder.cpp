@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <boost/iostreams/stream.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::network::bench;
+
+static const size_t rounds = 20;
+static const uint32_t version = message::version::level::maximum;
+
+// Enough small transactions for a payload above the parallel minimum.
+static const size_t transactions = 20000;
+
+static data_chunk synthetic_block()
+{
+    chain::transaction::list list;
+
+    for (size_t index = 0; index < transactions; ++index)
+    {
+        const auto tag = static_cast<uint32_t>(index);
+        const chain::input::list inputs
+        {
+            { { null_hash, tag }, chain::script{}, max_uint32 }
+        };
+
+        const chain::output::list outputs
+        {
+            { tag, chain::script{} },
+            { tag + 1u, chain::script{} }
+        };
+
+        list.emplace_back(1u, tag, inputs, outputs);
+    }
+
+    const chain::header header(1u, null_hash, null_hash, 0u, 0u, 0u);
+    return message::block(header, list).to_data(version);
+}
+
+// Decode and hash all transactions, as handlers of a block do.
+static void decode(const block_decoder& decoder, const data_chunk& payload)
+{
+    message::block block;
+    decoder.decode(version, payload, block);
+
+    for (const auto& transaction: block.transactions())
+        transaction.hash();
+}
+
+static void parse(const data_chunk& payload)
+{
+    typedef boost::iostreams::stream<byte_source<data_chunk>> stream;
+    byte_source<data_chunk> source(payload);
+    stream istream(source);
+
+    message::block block;
+    block.from_data(version, istream);
+
+    for (const auto& transaction: block.transactions())
+        transaction.hash();
+}
+
+BENCHMARK(block_decoder__decode_block)
+{
+    const auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+    threadpool pool;
+    pool.spawn(threads);
+
+    const auto payload = synthetic_block();
+    const block_decoder serial(pool, max_size_t);
+    const block_decoder parallel(pool, 0);
+
+    report("payload bytes", std::to_string(payload.size()));
+    measure("stream parse, hash on read", rounds, [&](size_t)
+    {
+        parse(payload);
+    });
+    measure("decoder, serial", rounds, [&](size_t)
+    {
+        decode(serial, payload);
+    });
+    measure("decoder, parallel (" + std::to_string(threads) + " threads)",
+        rounds, [&](size_t)
+    {
+        decode(parallel, payload);
+    });
+
+    pool.shutdown();
+    pool.join();
+}
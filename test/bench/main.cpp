@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace libbitcoin {
+namespace network {
+namespace bench {
+
+typedef std::map<std::string, function> registry;
+
+// Registration happens during static initialization, in any order.
+static registry& benchmarks()
+{
+    static registry instance;
+    return instance;
+}
+
+registrar::registrar(const char* name, function body)
+{
+    benchmarks()[name] = body;
+}
+
+void report(const std::string& name, size_t operations,
+    const clock::duration& elapsed)
+{
+    typedef std::chrono::duration<double, std::nano> nanoseconds;
+    const auto total = std::chrono::duration_cast<nanoseconds>(elapsed);
+
+    std::cout << "  " << std::left << std::setw(48) << name << std::right
+        << std::setw(12) << std::fixed << std::setprecision(1)
+        << total.count() / (operations == 0 ? 1 : operations) << " ns/op ("
+        << operations << " ops)" << std::endl;
+}
+
+void report(const std::string& name, const std::string& value)
+{
+    std::cout << "  " << std::left << std::setw(48) << name << std::right
+        << std::setw(12) << value << std::endl;
+}
+
+} // namespace bench
+} // namespace network
+} // namespace libbitcoin
+
+using namespace libbitcoin::network::bench;
+
+// Run all benchmarks, or those whose name contains the first argument.
+int main(int argc, char* argv[])
+{
+    const std::string filter = argc > 1 ? argv[1] : "";
+
+    for (const auto& benchmark: benchmarks())
+    {
+        if (benchmark.first.find(filter) == std::string::npos)
+            continue;
+
+        std::cout << benchmark.first << std::endl;
+        benchmark.second();
+    }
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::message;
+using namespace bc::network;
+using namespace bc::network::bench;
+
+typedef priority_dispatcher::priority priority;
+
+static const size_t rounds = 1000;
+static const auto bulk_work = std::chrono::microseconds(50);
+
+static void spin(const clock::duration& period)
+{
+    const auto end = clock::now() + period;
+    while (clock::now() < end);
+}
+
+// The time from load of a ping until its handler runs, while the handler
+// thread is occupied with a bulk job.
+static clock::duration ping_latency(bool inlined)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    clock::duration total(0);
+    const std::string payload(sizeof(uint64_t), '\0');
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        std::promise<void> started;
+        dispatch.post(priority::bulk, [&started]()
+        {
+            started.set_value();
+            spin(bulk_work);
+        });
+
+        started.get_future().wait();
+
+        std::promise<clock::time_point> handled;
+        const auto handler = [&handled](const code& ec, ping::const_ptr)
+        {
+            if (!ec)
+                handled.set_value(clock::now());
+
+            return false;
+        };
+
+        if (inlined)
+            subscriber.subscribe_inline<ping>(handler);
+        else
+            subscriber.subscribe<ping>(handler);
+
+        std::istringstream stream(payload);
+        const auto loaded = clock::now();
+        subscriber.load(message_type::ping, version::level::maximum, stream,
+            []() {});
+        total += handled.get_future().get() - loaded;
+
+        // Wait for the queued notification so that rounds are independent.
+        std::promise<void> drained;
+        dispatch.post(priority::bulk, [&drained]() { drained.set_value(); });
+        drained.get_future().wait();
+    }
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+    return total;
+}
+
+BENCHMARK(message_subscriber__ping_while_handler_busy)
+{
+    report("inline", rounds, ping_latency(true));
+    report("queued on control lane", rounds, ping_latency(false));
+}
+
+static const size_t subscriptions = 1000;
+
+// A bound protocol handler, held in the subscription list without a copy.
+struct handler_owner
+{
+    bool handle(const code& ec, ping::const_ptr, size_t& handled) const
+    {
+        ++handled;
+        return !ec;
+    }
+};
+
+BENCHMARK(message_subscriber__subscribe_relay)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    const auto owner = std::make_shared<handler_owner>();
+    size_t handled = 0;
+
+    measure("subscribe", subscriptions, [&](size_t)
+    {
+        using namespace std::placeholders;
+        subscriber.subscribe<ping>(std::bind(&handler_owner::handle, owner,
+            _1, _2, std::ref(handled)));
+    });
+
+    // Each relay invokes all of the resubscribing handlers above.
+    std::atomic<size_t> relayed(0);
+    std::promise<void> drained;
+    const std::string payload(sizeof(uint64_t), '\0');
+
+    subscriber.subscribe<ping>([&](const code& ec, ping::const_ptr)
+    {
+        if (!ec && ++relayed == rounds)
+            drained.set_value();
+
+        return !ec;
+    });
+
+    const auto elapsed = time([&]()
+    {
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            std::istringstream stream(payload);
+            subscriber.load(message_type::ping, version::level::maximum,
+                stream, []() {});
+        }
+
+        drained.get_future().wait();
+    });
+
+    report("relay to each handler", rounds * (subscriptions + 1), elapsed);
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
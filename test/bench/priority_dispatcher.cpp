@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::network::bench;
+
+typedef priority_dispatcher::priority priority;
+
+// Bulk jobs stand in for block and transaction handling.
+static const size_t backlog = 1000;
+static const size_t rounds = 20;
+static const auto bulk_work = std::chrono::microseconds(20);
+
+static void spin(const clock::duration& period)
+{
+    const auto end = clock::now() + period;
+    while (clock::now() < end);
+}
+
+// The time from post of a ping handler behind a bulk backlog until it runs.
+static clock::duration ping_latency(priority lane)
+{
+    threadpool pool;
+    pool.spawn(2);
+    priority_dispatcher dispatch(pool, 2, 0);
+    clock::duration total(0);
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (size_t job = 0; job < backlog; ++job)
+            dispatch.post(priority::bulk, []() { spin(bulk_work); });
+
+        std::promise<clock::time_point> ran;
+        const auto posted = clock::now();
+        dispatch.post(lane, [&ran]() { ran.set_value(clock::now()); });
+        total += ran.get_future().get() - posted;
+
+        // Drain the backlog so that rounds are independent.
+        std::promise<void> drained;
+        dispatch.post(priority::bulk, [&drained]() { drained.set_value(); });
+        drained.get_future().wait();
+    }
+
+    pool.shutdown();
+    pool.join();
+    return total;
+}
+
+BENCHMARK(priority_dispatcher__ping_behind_bulk_backlog)
+{
+    report("control lane", rounds, ping_latency(priority::control));
+    report("bulk lane (single queue)", rounds, ping_latency(priority::bulk));
+}
+
+BENCHMARK(priority_dispatcher__post)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    static const size_t jobs = 100000;
+
+    std::promise<void> done;
+    measure("post and run", jobs, [&dispatch, &done](size_t job)
+    {
+        if (job + 1 == jobs)
+            dispatch.post(priority::bulk, [&done]() { done.set_value(); });
+        else
+            dispatch.post(priority::bulk, []() {});
+    });
+
+    done.get_future().wait();
+    pool.shutdown();
+    pool.join();
+}
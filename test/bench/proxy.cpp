@@ -0,0 +1,218 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::network::bench;
+
+static const size_t messages = 100000;
+
+// Reference count operations of the calling thread. Each is one atomic
+// read-modify-write on the control block of the shared pointer.
+static thread_local size_t atomics = 0;
+
+// A shared pointer that counts the atomic operations it causes. A copy
+// increments, the release of a held reference decrements, a move does
+// neither.
+template <typename Type>
+class counted_ptr
+{
+public:
+    counted_ptr()
+    {
+    }
+
+    explicit counted_ptr(std::shared_ptr<Type>&& pointer)
+      : pointer_(std::move(pointer))
+    {
+    }
+
+    counted_ptr(const counted_ptr& other)
+      : pointer_(other.pointer_)
+    {
+        atomics += pointer_ ? 1 : 0;
+    }
+
+    counted_ptr(counted_ptr&& other) noexcept
+      : pointer_(std::move(other.pointer_))
+    {
+    }
+
+    ~counted_ptr()
+    {
+        atomics += pointer_ ? 1 : 0;
+    }
+
+    counted_ptr& operator=(const counted_ptr&) = delete;
+
+    Type* operator->() const
+    {
+        return pointer_.get();
+    }
+
+private:
+    std::shared_ptr<Type> pointer_;
+};
+
+struct decoded
+{
+    uint64_t nonce;
+};
+
+typedef counted_ptr<const decoded> message_ptr;
+
+// The read cycle of proxy, one message per cycle. Each step is an
+// asynchronous hop: read_heading, handle_read_heading, read_payload,
+// handle_read_payload and resume_read. The decoded message is handed to a
+// subscriber job and reading resumes from a job that may run elsewhere.
+class reader
+  : public std::enable_shared_from_this<reader>
+{
+public:
+    typedef counted_ptr<reader> ptr;
+
+    reader(asio::service& service, bool moved)
+      : moved_(moved), service_(service), remaining_(0), handled_(0)
+    {
+    }
+
+    void start(size_t count)
+    {
+        remaining_ = count;
+        hop(self(), &reader::read_heading);
+    }
+
+    size_t handled() const
+    {
+        return handled_;
+    }
+
+private:
+    typedef void (reader::*step)(ptr&&);
+
+    // Taking a strong reference from the weak one is an atomic exchange.
+    ptr self()
+    {
+        ++atomics;
+        return ptr(shared_from_this());
+    }
+
+    // Either the reference is moved to the next step or each step takes
+    // its own, as with binding shared_from_this() at every hop.
+    void hop(ptr&& current, step next)
+    {
+        if (moved_)
+        {
+            service_.post([current = std::move(current), next]() mutable
+            {
+                const auto instance = current.operator->();
+                (instance->*next)(std::move(current));
+            });
+
+            return;
+        }
+
+        service_.post([owner = self(), next]() mutable
+        {
+            const auto instance = owner.operator->();
+            (instance->*next)(ptr());
+        });
+    }
+
+    void read_heading(ptr&& current)
+    {
+        if (remaining_-- == 0)
+            return;
+
+        hop(std::move(current), &reader::handle_read_heading);
+    }
+
+    void handle_read_heading(ptr&& current)
+    {
+        hop(std::move(current), &reader::read_payload);
+    }
+
+    void read_payload(ptr&& current)
+    {
+        hop(std::move(current), &reader::handle_read_payload);
+    }
+
+    void handle_read_payload(ptr&& current)
+    {
+        message_ptr message(std::make_shared<const decoded>(decoded{ 0 }));
+
+        // The subscriber job receives the message, copied or moved.
+        if (moved_)
+            deliver(std::move(message));
+        else
+            deliver(message);
+
+        // The resume job is a handoff to another thread, so it copies.
+        const auto resume = moved_ ? current : self();
+        hop(std::move(current), &reader::resume_read);
+    }
+
+    void resume_read(ptr&& current)
+    {
+        hop(std::move(current), &reader::read_heading);
+    }
+
+    void deliver(message_ptr message)
+    {
+        service_.post([this, message = std::move(message)]()
+        {
+            handled_ += message->nonce == 0 ? 1 : 0;
+        });
+    }
+
+    const bool moved_;
+    asio::service& service_;
+    size_t remaining_;
+    size_t handled_;
+};
+
+static void read_cycle(const std::string& name, bool moved)
+{
+    asio::service service;
+    const auto instance = std::make_shared<reader>(service, moved);
+
+    atomics = 0;
+    const auto elapsed = time([&]()
+    {
+        instance->start(messages);
+        service.run();
+    });
+
+    report(name, messages, elapsed);
+    report(name + " (atomics per message)",
+        std::to_string(atomics / messages));
+}
+
+BENCHMARK(proxy__read_cycle_reference_counts)
+{
+    read_cycle("reference per hop", false);
+    read_cycle("reference moved", true);
+}
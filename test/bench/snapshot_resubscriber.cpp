@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::network::bench;
+
+typedef snapshot_resubscriber<code, size_t> test_subscriber;
+
+static const size_t invokes = 200000;
+static const size_t handlers = 4;
+
+// The time for each of threads to invoke one instance, all resubscribing.
+static clock::duration contended_invoke(size_t threads)
+{
+    threadpool pool;
+    const auto instance = std::make_shared<test_subscriber>(pool, "bench");
+    instance->start();
+
+    std::atomic<size_t> calls(0);
+
+    for (size_t handler = 0; handler < handlers; ++handler)
+        instance->subscribe([&calls](const code&, size_t value)
+        {
+            calls.fetch_add(value, std::memory_order_relaxed);
+            return true;
+        }, error::service_stopped, 0);
+
+    std::promise<void> start;
+    const auto started = start.get_future().share();
+    std::vector<std::thread> invokers;
+
+    for (size_t thread = 0; thread < threads; ++thread)
+        invokers.emplace_back([&instance, started]()
+        {
+            started.wait();
+
+            for (size_t invoke = 0; invoke < invokes; ++invoke)
+                instance->invoke(error::success, 1);
+        });
+
+    const auto elapsed = time([&]()
+    {
+        start.set_value();
+
+        for (auto& invoker: invokers)
+            invoker.join();
+    });
+
+    instance->stop();
+    instance->invoke(error::service_stopped, 0);
+    return elapsed;
+}
+
+BENCHMARK(snapshot_resubscriber__contended_invoke)
+{
+    for (const size_t threads: { 1, 2, 4, 8 })
+        report(std::to_string(threads) + " threads", threads * invokes,
+            contended_invoke(threads));
+}
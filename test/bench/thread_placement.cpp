@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::network::bench;
+
+static const size_t buffer_size = 8 * 1024 * 1024;
+static const size_t passes = 20;
+static const size_t cache_line = 64;
+
+// Each thread allocates and repeatedly reads and writes its own buffer, as
+// a channel does with its read buffer.
+static clock::duration touch_buffers(const thread_placement& placement,
+    size_t threads)
+{
+    threadpool pool;
+    pool.spawn(threads);
+
+    if (!placement.empty() && !placement.apply(pool, threads))
+        report("placement", "failed");
+
+    std::atomic<size_t> remaining(threads);
+    std::atomic<uint64_t> total(0);
+    std::promise<void> done;
+
+    const auto elapsed = time([&]()
+    {
+        for (size_t thread = 0; thread < threads; ++thread)
+        {
+            pool.service().post([&]()
+            {
+                std::vector<uint8_t> buffer(buffer_size);
+                uint64_t sum = 0;
+
+                for (size_t pass = 0; pass < passes; ++pass)
+                    for (size_t byte = 0; byte < buffer.size();
+                        byte += cache_line)
+                        sum += ++buffer[byte];
+
+                total += sum;
+
+                if (--remaining == 0)
+                    done.set_value();
+            });
+        }
+
+        done.get_future().wait();
+    });
+
+    pool.shutdown();
+    pool.join();
+    return elapsed;
+}
+
+BENCHMARK(thread_placement__buffer_throughput)
+{
+    const auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const auto nodes = thread_placement::numa_nodes().size();
+    const auto operations = threads * passes;
+
+    report("processors", std::to_string(threads));
+    report("numa nodes", std::to_string(nodes));
+    report("unplaced (per buffer pass)", operations,
+        touch_buffers(thread_placement({}, false), threads));
+    report("numa placed (per buffer pass)", operations,
+        touch_buffers(thread_placement({}, true), threads));
+}
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static const uint32_t version = message::version::level::maximum;
+
+static message::block synthetic_block(size_t count)
+{
+    chain::transaction::list transactions;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto tag = static_cast<uint32_t>(index);
+        const chain::input::list inputs
+        {
+            { { null_hash, tag }, chain::script{}, max_uint32 }
+        };
+
+        const chain::output::list outputs
+        {
+            { tag, chain::script{} },
+            { tag + 1u, chain::script{} }
+        };
+
+        transactions.emplace_back(1u, tag, inputs, outputs);
+    }
+
+    const chain::header header(1u, null_hash, null_hash, 0u, 0u, 0u);
+    return{ header, transactions };
+}
+
+BOOST_AUTO_TEST_SUITE(block_decoder_tests)
+
+BOOST_AUTO_TEST_CASE(block_decoder__scan__truncated__false)
+{
+    const auto payload = synthetic_block(3).to_data(version);
+    const data_chunk truncated(payload.begin(), payload.end() - 1);
+
+    block_decoder::offsets ends;
+    BOOST_REQUIRE(block_decoder::scan(payload, 81, 3, ends));
+    BOOST_REQUIRE_EQUAL(ends.size(), 3u);
+    BOOST_REQUIRE_EQUAL(ends.back(), payload.size());
+    BOOST_REQUIRE(!block_decoder::scan(truncated, 81, 3, ends));
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__decode__parallel__matches_serial)
+{
+    threadpool pool;
+    pool.spawn(4);
+    const block_decoder decoder(pool, 0);
+    const auto expected = synthetic_block(1000);
+    const auto payload = expected.to_data(version);
+
+    message::block block;
+    BOOST_REQUIRE(decoder.decode(version, payload, block));
+    BOOST_REQUIRE_EQUAL(block.transactions().size(), 1000u);
+    BOOST_REQUIRE(block.to_data(version) == payload);
+    BOOST_REQUIRE(block.header().hash() == expected.header().hash());
+    BOOST_REQUIRE(block.transactions()[999].hash() ==
+        expected.transactions()[999].hash());
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__decode__trailing_bytes__false)
+{
+    threadpool pool;
+    pool.spawn(2);
+    const block_decoder decoder(pool, 0);
+    auto payload = synthetic_block(100).to_data(version);
+    payload.push_back(0x00);
+
+    message::block block;
+    BOOST_REQUIRE(!decoder.decode(version, payload, block));
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__decode__transaction__expected_hash)
+{
+    threadpool pool;
+    const block_decoder decoder(pool, max_size_t);
+    const auto expected = synthetic_block(1).transactions().front();
+    const auto payload = expected.to_data();
+
+    message::transaction transaction;
+    BOOST_REQUIRE(decoder.decode(version, payload, transaction));
+    BOOST_REQUIRE(transaction.hash() == expected.hash());
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__decode__headers__expected_hashes)
+{
+    threadpool pool;
+    const block_decoder decoder(pool, max_size_t);
+    message::header::list elements;
+
+    for (uint32_t nonce = 0; nonce < 37; ++nonce)
+        elements.emplace_back(1u, null_hash, null_hash, nonce, 0u, nonce);
+
+    const message::headers expected(elements);
+    const auto payload = expected.to_data(version);
+
+    message::headers headers;
+    BOOST_REQUIRE(decoder.decode(version, payload, headers));
+    BOOST_REQUIRE_EQUAL(headers.elements().size(), 37u);
+    BOOST_REQUIRE(headers.to_data(version) == payload);
+    BOOST_REQUIRE(headers.elements()[36].hash() == elements[36].hash());
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__check_work__genesis__true)
+{
+    const auto genesis = chain::block::genesis_mainnet();
+    const message::headers headers({ message::header(genesis.header()) });
+
+    BOOST_REQUIRE(block_decoder::check_work(message::message_type::block,
+        genesis.to_data()));
+    BOOST_REQUIRE(block_decoder::check_work(message::message_type::headers,
+        headers.to_data(version)));
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__check_work__bad_nonce__false)
+{
+    auto payload = chain::block::genesis_mainnet().to_data();
+    payload[76] ^= 0x01;
+
+    BOOST_REQUIRE(!block_decoder::check_work(message::message_type::block,
+        payload));
+    BOOST_REQUIRE(block_decoder::check_work(message::message_type::ping,
+        payload));
+}
+
+BOOST_AUTO_TEST_CASE(block_decoder__segregated__unsegregated_block__false)
+{
+    const auto payload = synthetic_block(3).to_data(version);
+    BOOST_REQUIRE(!block_decoder::segregated(message::message_type::block,
+        payload));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(connection_slab_tests)
+
+BOOST_AUTO_TEST_CASE(connection_slab__construct__zero_size__disabled)
+{
+    connection_slab slab(10, 0);
+    BOOST_REQUIRE(!slab.enabled());
+    BOOST_REQUIRE_EQUAL(slab.available(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection_slab__lease__released__entry_available)
+{
+    connection_slab slab(2, 1024);
+    BOOST_REQUIRE(slab.enabled());
+    std::shared_ptr<uint64_t> first;
+    std::shared_ptr<uint64_t> second;
+    {
+        const connection_slab::lease lease(slab);
+        BOOST_REQUIRE(lease.get_allocator().source() != nullptr);
+        BOOST_REQUIRE_EQUAL(slab.available(), 1u);
+
+        first = std::allocate_shared<uint64_t>(lease.get_allocator(), 42);
+        second = std::allocate_shared<uint64_t>(lease.get_allocator(), 24);
+    }
+
+    // The allocations hold the entry beyond the lease.
+    BOOST_REQUIRE_EQUAL(slab.available(), 1u);
+    first.reset();
+    BOOST_REQUIRE_EQUAL(slab.available(), 1u);
+    second.reset();
+    BOOST_REQUIRE_EQUAL(slab.available(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(connection_slab__lease__exhausted__heap_allocator)
+{
+    connection_slab slab(1, 1024);
+    const connection_slab::lease first(slab);
+    const connection_slab::lease second(slab);
+    BOOST_REQUIRE(first.get_allocator().source() != nullptr);
+    BOOST_REQUIRE(second.get_allocator().source() == nullptr);
+
+    const auto value = std::allocate_shared<uint64_t>(
+        second.get_allocator(), 42);
+    BOOST_REQUIRE_EQUAL(*value, 42u);
+}
+
+BOOST_AUTO_TEST_CASE(connection_slab__entry__allocate_beyond_size__null)
+{
+    connection_slab slab(1, 64);
+    const connection_slab::lease lease(slab);
+    const auto entry = lease.get_allocator().source();
+    BOOST_REQUIRE(entry->allocate(128) == nullptr);
+
+    const auto block = entry->allocate(32);
+    BOOST_REQUIRE(block != nullptr);
+    BOOST_REQUIRE(entry->deallocate(block));
+
+    uint64_t outside;
+    BOOST_REQUIRE(!entry->deallocate(&outside));
+}
+
+BOOST_AUTO_TEST_CASE(connection_slab__allocator__first_allocation_too_large__entry_held)
+{
+    typedef std::array<uint8_t, 128> large_block;
+    connection_slab slab(1, 64);
+    connection_slab::byte_allocator allocator;
+    std::shared_ptr<large_block> large;
+    {
+        const connection_slab::lease lease(slab);
+        allocator = lease.get_allocator();
+
+        // Falls back to the heap, nothing is allocated from the entry.
+        large = std::allocate_shared<large_block>(lease.get_allocator());
+    }
+
+    // The allocators hold the entry, so it is not returned to the slab.
+    BOOST_REQUIRE_EQUAL(slab.available(), 0u);
+    auto small = std::allocate_shared<uint64_t>(allocator, 42);
+    BOOST_REQUIRE_EQUAL(*small, 42u);
+
+    large.reset();
+    allocator = connection_slab::byte_allocator();
+    BOOST_REQUIRE_EQUAL(slab.available(), 0u);
+
+    // Returned once, with the last allocation.
+    small.reset();
+    BOOST_REQUIRE_EQUAL(slab.available(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+typedef header_hasher::kernel kernel;
+
+static const size_t stride = header_hasher::header_size + 1;
+
+// Enough headers for full batches of every kernel and a remainder.
+static data_chunk synthetic_headers(size_t count)
+{
+    data_chunk headers(count * stride);
+
+    for (size_t index = 0; index < headers.size(); ++index)
+        headers[index] = static_cast<uint8_t>(index * 7 + index / 251);
+
+    return headers;
+}
+
+BOOST_AUTO_TEST_SUITE(header_hasher_tests)
+
+BOOST_AUTO_TEST_CASE(header_hasher__supported__scalar__true)
+{
+    BOOST_REQUIRE(header_hasher::supported(kernel::scalar));
+    BOOST_REQUIRE(header_hasher::supported(header_hasher::selected()));
+}
+
+BOOST_AUTO_TEST_CASE(header_hasher__hash__genesis__expected)
+{
+    const auto header = chain::block::genesis_mainnet().header();
+    const auto data = header.to_data();
+    hash_digest hash;
+
+    header_hasher::hash(data.data(), data.size(), 1, &hash);
+    BOOST_REQUIRE_EQUAL(encode_hash(hash),
+        "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f");
+}
+
+BOOST_AUTO_TEST_CASE(header_hasher__hash__all_kernels__match_bitcoin_hash)
+{
+    const size_t count = 53;
+    const auto headers = synthetic_headers(count);
+    std::vector<hash_digest> hashes(count);
+
+    for (const auto use: { kernel::scalar, kernel::sha_ni, kernel::avx2,
+        kernel::avx512 })
+    {
+        if (!header_hasher::supported(use))
+            continue;
+
+        header_hasher::hash(use, headers.data(), stride, count, hashes.data());
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            const auto begin = headers.data() + index * stride;
+            const auto end = begin + header_hasher::header_size;
+            const auto expected = bitcoin_hash(data_slice(begin, end));
+            BOOST_REQUIRE(hashes[index] == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(memory_governor_tests)
+
+typedef memory_governor::category category;
+typedef memory_governor::pressure pressure;
+
+BOOST_AUTO_TEST_CASE(memory_governor__reserve__zero_budget__accounted_not_enforced)
+{
+    memory_governor governor(0);
+    governor.reserve(category::payload, 100);
+    BOOST_REQUIRE(!governor.enabled());
+    BOOST_REQUIRE_EQUAL(governor.usage(), 100u);
+    BOOST_REQUIRE(governor.level() == pressure::none);
+    BOOST_REQUIRE(!governor.paused());
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__usage__categories__exported_separately)
+{
+    memory_governor governor(1000);
+    governor.reserve(category::payload, 1);
+    governor.reserve(category::outbound, 2);
+    governor.reserve(category::relay, 3);
+    governor.reserve(category::hosts, 4);
+    governor.release(category::relay, 3);
+    BOOST_REQUIRE_EQUAL(governor.usage(category::payload), 1u);
+    BOOST_REQUIRE_EQUAL(governor.usage(category::outbound), 2u);
+    BOOST_REQUIRE_EQUAL(governor.usage(category::relay), 0u);
+    BOOST_REQUIRE_EQUAL(governor.usage(category::hosts), 4u);
+    BOOST_REQUIRE_EQUAL(governor.usage(), 7u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__level__over_budget__staged)
+{
+    memory_governor governor(800);
+    governor.reserve(category::relay, 800);
+    BOOST_REQUIRE(governor.level() == pressure::none);
+    governor.reserve(category::relay, 1);
+    BOOST_REQUIRE(governor.level() == pressure::pause_reads);
+    governor.reserve(category::relay, 100);
+    BOOST_REQUIRE(governor.level() == pressure::refuse_inbound);
+    governor.reserve(category::relay, 100);
+    BOOST_REQUIRE(governor.level() == pressure::disconnect);
+    governor.release(category::relay, 1001);
+    BOOST_REQUIRE(governor.level() == pressure::none);
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__suspend__within_budget__invoked)
+{
+    memory_governor governor(100);
+    governor.start(nullptr);
+    auto resumed = false;
+    governor.suspend([&resumed]() { resumed = true; });
+    BOOST_REQUIRE(resumed);
+    governor.stop();
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__suspend__over_budget__resumed_on_release)
+{
+    memory_governor governor(100);
+    governor.start(nullptr);
+    governor.reserve(category::payload, 150);
+    size_t resumed = 0;
+    governor.suspend([&resumed]() { ++resumed; });
+    governor.suspend([&resumed]() { ++resumed; });
+    BOOST_REQUIRE_EQUAL(resumed, 0u);
+
+    // Still over budget.
+    governor.release(category::payload, 25);
+    BOOST_REQUIRE_EQUAL(resumed, 0u);
+
+    governor.release(category::payload, 25);
+    BOOST_REQUIRE_EQUAL(resumed, 2u);
+    governor.stop();
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__stop__suspended__resumed)
+{
+    memory_governor governor(100);
+    governor.start(nullptr);
+    governor.reserve(category::payload, 150);
+    auto resumed = false;
+    governor.suspend([&resumed]() { resumed = true; });
+    BOOST_REQUIRE(!resumed);
+    governor.stop();
+    BOOST_REQUIRE(resumed);
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__suspend__stopped__released)
+{
+    memory_governor governor(100);
+    auto resumed = false;
+    governor.suspend([&resumed]() { resumed = true; });
+    BOOST_REQUIRE(!resumed);
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__reserve__disconnect_stage__evicts_once_per_entry)
+{
+    memory_governor governor(800);
+    size_t evictions = 0;
+    governor.start([&evictions]() { ++evictions; });
+    governor.reserve(category::outbound, 1001);
+    governor.reserve(category::outbound, 1);
+    BOOST_REQUIRE_EQUAL(evictions, 1u);
+
+    // Leaving the stage rearms the request.
+    governor.release(category::outbound, 2);
+    governor.reserve(category::outbound, 2);
+    BOOST_REQUIRE_EQUAL(evictions, 2u);
+    governor.stop();
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__account__destruct__releases_remainder)
+{
+    memory_governor governor(0);
+    {
+        memory_governor::account account(governor);
+        account.reserve(category::payload, 10);
+        account.reserve(category::relay, 20);
+        account.release(category::relay, 5);
+        BOOST_REQUIRE_EQUAL(account.usage(), 25u);
+        BOOST_REQUIRE_EQUAL(governor.usage(), 25u);
+    }
+
+    BOOST_REQUIRE_EQUAL(governor.usage(), 0u);
+    BOOST_REQUIRE_EQUAL(governor.usage(category::payload), 0u);
+    BOOST_REQUIRE_EQUAL(governor.usage(category::relay), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__level__category_over_limit__pause_only)
+{
+    memory_governor::limits limits{};
+    limits[static_cast<size_t>(category::relay)] = 100;
+    memory_governor governor(0, limits);
+    governor.start(nullptr);
+    BOOST_REQUIRE(governor.enabled());
+    BOOST_REQUIRE_EQUAL(governor.limit(category::relay), 100u);
+
+    // Other categories are not limited and there is no overall budget.
+    governor.reserve(category::outbound, 10000);
+    BOOST_REQUIRE(governor.level() == pressure::none);
+
+    governor.reserve(category::relay, 101);
+    BOOST_REQUIRE(governor.level() == pressure::pause_reads);
+    BOOST_REQUIRE(governor.over(category::relay));
+    BOOST_REQUIRE(!governor.over(category::outbound));
+
+    auto resumed = false;
+    governor.suspend([&resumed]() { resumed = true; });
+    BOOST_REQUIRE(!resumed);
+    governor.release(category::relay, 1);
+    BOOST_REQUIRE(resumed);
+    governor.stop();
+}
+
+BOOST_AUTO_TEST_CASE(memory_governor__account__backlogged__relay_or_outbound_only)
+{
+    memory_governor governor(100);
+    memory_governor::account reader(governor);
+    memory_governor::account relayer(governor);
+    reader.reserve(category::payload, 150);
+    BOOST_REQUIRE(governor.paused());
+
+    // An idle read buffer is not backlog, its reads need not pause.
+    BOOST_REQUIRE(!reader.backlogged());
+    relayer.reserve(category::relay, 1);
+    BOOST_REQUIRE(relayer.backlogged());
+    BOOST_REQUIRE(!reader.backlogged());
+    BOOST_REQUIRE_EQUAL(relayer.usage(category::relay), 1u);
+
+    reader.release(category::payload, 150);
+    BOOST_REQUIRE(!relayer.backlogged());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+// Counts destruction, as a pooled instance is only destroyed if not kept.
+struct counted
+{
+    static std::atomic<size_t> destroyed;
+
+    ~counted()
+    {
+        ++destroyed;
+    }
+
+    void reset()
+    {
+    }
+};
+
+std::atomic<size_t> counted::destroyed(0);
+
+BOOST_AUTO_TEST_SUITE(message_pool_tests)
+
+BOOST_AUTO_TEST_CASE(message_pool__acquire__released__recycled)
+{
+    const void* first;
+    {
+        const auto instance = message_pool<ping>::acquire();
+        first = instance.get();
+    }
+
+    const auto second = message_pool<ping>::acquire();
+    BOOST_REQUIRE(second.get() == first);
+}
+
+BOOST_AUTO_TEST_CASE(message_pool__acquire__held__distinct)
+{
+    const auto first = message_pool<pong>::acquire();
+    const auto second = message_pool<pong>::acquire();
+    BOOST_REQUIRE(first.get() != second.get());
+}
+
+BOOST_AUTO_TEST_CASE(message_pool__make_message__pooled__recycled)
+{
+    static_assert(is_pooled<inventory>::value, "pooled");
+    const void* first;
+    {
+        first = make_message<inventory>().get();
+    }
+
+    BOOST_REQUIRE(make_message<inventory>().get() == first);
+}
+
+BOOST_AUTO_TEST_CASE(message_pool__make_message__not_pooled__allocated)
+{
+    static_assert(!is_pooled<block>::value, "not pooled");
+    BOOST_REQUIRE(make_message<block>());
+}
+
+BOOST_AUTO_TEST_CASE(recycling_allocator__allocate__deallocated__recycled)
+{
+    recycling_allocator<uint64_t> allocator;
+    const auto first = allocator.allocate(1);
+    allocator.deallocate(first, 1);
+    const auto second = allocator.allocate(1);
+    allocator.deallocate(second, 1);
+    BOOST_REQUIRE(first == second);
+}
+
+BOOST_AUTO_TEST_CASE(message_pool__acquire__released_on_other_thread__recycled)
+{
+    auto instance = message_pool<verack>::acquire();
+    const void* first = instance.get();
+
+    // Released as a handler thread releases a message from a network thread.
+    std::thread thread([&instance]()
+    {
+        instance.reset();
+    });
+
+    thread.join();
+    BOOST_REQUIRE(message_pool<verack>::acquire().get() == first);
+}
+
+BOOST_AUTO_TEST_CASE(recycling_allocator__rebound_on_other_thread__recycled)
+{
+    recycling_allocator<uint32_t> allocator;
+    const auto first = allocator.allocate(1);
+
+    // Rebound on the releasing thread, as a control block is released.
+    std::thread thread([&allocator, first]()
+    {
+        recycling_allocator<uint64_t> rebound(allocator);
+        rebound.deallocate(reinterpret_cast<uint64_t*>(first), 1);
+    });
+
+    thread.join();
+    const auto second = allocator.allocate(1);
+    allocator.deallocate(second, 1);
+    BOOST_REQUIRE(first == second);
+}
+
+BOOST_AUTO_TEST_CASE(message_pool__release__after_thread_list_destroyed__deleted)
+{
+    std::thread thread([]()
+    {
+        // Constructed before the freelist, so destroyed after it.
+        static thread_local message_pool<counted>::ptr held;
+        held = message_pool<counted>::acquire();
+    });
+
+    thread.join();
+    BOOST_REQUIRE_EQUAL(counted::destroyed.load(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(message_pool__release__after_acquiring_thread_exit__deleted)
+{
+    const auto before = counted::destroyed.load();
+    message_pool<counted>::ptr instance;
+    std::thread thread([&instance]()
+    {
+        instance = message_pool<counted>::acquire();
+    });
+
+    thread.join();
+    instance.reset();
+    BOOST_REQUIRE_EQUAL(counted::destroyed.load(), before + 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,307 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+BOOST_AUTO_TEST_SUITE(message_subscriber_tests)
+
+BOOST_AUTO_TEST_CASE(message_subscriber__subscribe_raw__raw_not_decoded)
+{
+    threadpool pool;
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    subscriber.subscribe_raw(message_type::transaction,
+        [](const code&, const heading&, message_subscriber::payload_ptr)
+        {
+            return true;
+        });
+
+    subscriber.subscribe<block>(
+        [](const code&, block::const_ptr)
+        {
+            return true;
+        });
+
+    BOOST_REQUIRE(subscriber.raw(message_type::transaction));
+    BOOST_REQUIRE(!subscriber.decoded(message_type::transaction));
+    BOOST_REQUIRE(!subscriber.raw(message_type::block));
+    BOOST_REQUIRE(subscriber.decoded(message_type::block));
+    subscriber.stop();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__relay_raw__subscribed_type__shared)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    std::promise<message_subscriber::payload_ptr> received;
+    subscriber.subscribe_raw(message_type::transaction,
+        [&received](const code& ec, const heading&,
+            message_subscriber::payload_ptr payload)
+        {
+            if (!ec)
+                received.set_value(payload);
+
+            return false;
+        });
+
+    const auto payload = std::make_shared<const data_chunk>(
+        data_chunk{ 1, 2, 3 });
+    const heading other(0, ping::command, 3, 0);
+    const heading expected(0, transaction::command, 3, 0);
+    subscriber.relay_raw(other, payload, []() {});
+    subscriber.relay_raw(expected, payload, []() {});
+
+    BOOST_REQUIRE(received.get_future().get() == payload);
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__load__inline__reading_thread_before_queued)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    const auto reader = std::this_thread::get_id();
+    std::atomic<bool> inlined(false);
+    std::thread::id inline_thread;
+    std::promise<bool> queued;
+
+    subscriber.subscribe<ping>(
+        [&inlined, &queued](const code& ec, ping::const_ptr)
+        {
+            if (!ec)
+                queued.set_value(inlined.load());
+
+            return false;
+        });
+
+    subscriber.subscribe_inline<ping>(
+        [&inlined, &inline_thread](const code& ec, ping::const_ptr)
+        {
+            if (!ec)
+            {
+                inline_thread = std::this_thread::get_id();
+                inlined = true;
+            }
+
+            return false;
+        });
+
+    // A ping payload is an eight byte nonce.
+    std::istringstream stream(std::string(8, '\0'));
+    const auto ec = subscriber.load(message_type::ping,
+        version::level::maximum, stream, []() {});
+
+    BOOST_REQUIRE_EQUAL(ec, error::success);
+    BOOST_REQUIRE(inlined);
+    BOOST_REQUIRE(inline_thread == reader);
+    BOOST_REQUIRE(queued.get_future().get());
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__load__unordered_bulk__arrival_order_not_concurrent)
+{
+    static const size_t messages = 500;
+
+    threadpool pool;
+    pool.spawn(4);
+    priority_dispatcher dispatch(pool, 4, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    std::atomic<size_t> running(0);
+    std::atomic<size_t> overlaps(0);
+    std::vector<size_t> sequence;
+    std::promise<void> handled;
+
+    subscriber.subscribe<inventory>(
+        [&](const code& ec, inventory::const_ptr message)
+        {
+            if (ec)
+                return false;
+
+            if (running.fetch_add(1) != 0)
+                ++overlaps;
+
+            const auto& hash = message->inventories().front().hash();
+            sequence.push_back(hash[0] + (size_t(hash[1]) << 8));
+            running.fetch_sub(1);
+
+            if (sequence.size() == messages)
+                handled.set_value();
+
+            return true;
+        });
+
+    for (size_t index = 0; index < messages; ++index)
+    {
+        auto hash = null_hash;
+        hash[0] = static_cast<uint8_t>(index);
+        hash[1] = static_cast<uint8_t>(index >> 8);
+        const inventory message(inventory_vector::list
+        {
+            { inventory_vector::type_id::transaction, hash }
+        });
+
+        const auto payload = message.to_data(version::level::maximum);
+        std::istringstream stream(std::string(payload.begin(),
+            payload.end()));
+        BOOST_REQUIRE_EQUAL(subscriber.load(message_type::inventory,
+            version::level::maximum, stream, []() {}), error::success);
+    }
+
+    // The default mode neither reorders nor parallelizes one channel's lane.
+    handled.get_future().wait();
+    BOOST_REQUIRE_EQUAL(overlaps.load(), 0u);
+
+    for (size_t index = 0; index < messages; ++index)
+        BOOST_REQUIRE_EQUAL(sequence[index], index);
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__decode__not_read_ahead__hashes_cached)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, false);
+    subscriber.start();
+
+    header::list elements;
+
+    for (uint32_t nonce = 0; nonce < 3; ++nonce)
+        elements.emplace_back(1u, null_hash, null_hash, nonce, 0u, nonce);
+
+    auto payload = headers(elements).to_data(version::level::maximum);
+    std::promise<hash_digest> received;
+
+    subscriber.subscribe<headers>(
+        [&received](const code& ec, headers::const_ptr message)
+        {
+            if (!ec)
+                received.set_value(message->elements().back().hash());
+
+            return false;
+        });
+
+    // A depth of one decodes from the read buffer, without a pipeline.
+    const auto ec = subscriber.decode(message_type::headers,
+        version::level::maximum, payload, []() {});
+
+    BOOST_REQUIRE_EQUAL(ec, error::success);
+    BOOST_REQUIRE(received.get_future().get() == elements.back().hash());
+
+    // Trailing bytes fail the decode, as they fail a stream load.
+    payload.push_back(0x00);
+    BOOST_REQUIRE_EQUAL(subscriber.decode(message_type::headers,
+        version::level::maximum, payload, []() {}), error::bad_stream);
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__decode__retained_not_read_ahead__payload_retained)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    message_subscriber subscriber(pool, dispatch,
+        connection_slab::byte_allocator(), false, false, false, true);
+    subscriber.start();
+
+    const chain::input::list inputs
+    {
+        { { null_hash, 0u }, chain::script{}, max_uint32 }
+    };
+
+    const chain::output::list outputs
+    {
+        { 1u, chain::script{} }
+    };
+
+    const transaction expected(1u, 0u, inputs, outputs);
+    const auto payload = std::make_shared<const data_chunk>(
+        expected.to_data(version::level::maximum));
+    std::promise<wire_payload::ptr> received;
+
+    BOOST_REQUIRE(subscriber.retained(message_type::transaction));
+
+    subscriber.subscribe<transaction>(
+        [&received](const code& ec, transaction::const_ptr message)
+        {
+            if (!ec)
+                received.set_value(wire_payload::find(message));
+
+            return false;
+        });
+
+    // A depth of one retains the payload for forwarding without a pipeline.
+    const auto ec = subscriber.decode(message_type::transaction,
+        version::level::maximum, payload, []() {});
+
+    BOOST_REQUIRE_EQUAL(ec, error::success);
+    const auto wire = received.get_future().get();
+    BOOST_REQUIRE(wire);
+    BOOST_REQUIRE(wire->portable());
+    BOOST_REQUIRE(wire->payload() == *payload);
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+static const auto type = message_type::transaction;
+
+// Long enough that the middle bytes are not sampled.
+static data_chunk make_payload(uint8_t middle)
+{
+    data_chunk payload(100, 7);
+    payload[50] = middle;
+    return payload;
+}
+
+BOOST_AUTO_TEST_SUITE(payload_cache_tests)
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__disabled__false)
+{
+    payload_cache cache(0);
+    const auto payload = make_payload(1);
+
+    BOOST_REQUIRE(!cache.enabled());
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE_EQUAL(cache.lookups(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__second_copy__dropped)
+{
+    payload_cache cache(10);
+    const auto payload = make_payload(1);
+
+    // The common race of two peers relaying one payload.
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE_EQUAL(cache.lookups(), 2u);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__repeats__true)
+{
+    payload_cache cache(10);
+    const auto payload = make_payload(1);
+
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE_EQUAL(cache.lookups(), 3u);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__same_sample_other_bytes__false)
+{
+    payload_cache cache(10);
+    const auto payload = make_payload(1);
+    const auto forged = make_payload(2);
+
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 42, forged));
+    BOOST_REQUIRE(!cache.duplicate(type, 42, forged));
+    BOOST_REQUIRE(cache.duplicate(type, 42, payload));
+}
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__forged_first__payload_not_dropped)
+{
+    payload_cache cache(10);
+    const auto payload = make_payload(1);
+    const auto forged = make_payload(2);
+
+    // A forged collision cannot suppress the payload that it collides with.
+    BOOST_REQUIRE(!cache.duplicate(type, 42, forged));
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(cache.duplicate(type, 42, forged));
+}
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__other_key__false)
+{
+    payload_cache cache(10);
+    const auto payload = make_payload(1);
+    data_chunk shorter(payload.begin(), payload.end() - 1);
+
+    BOOST_REQUIRE(!cache.duplicate(type, 42, payload));
+    BOOST_REQUIRE(!cache.duplicate(message_type::block, 42, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 43, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 42, shorter));
+}
+
+BOOST_AUTO_TEST_CASE(payload_cache__duplicate__over_capacity__oldest_evicted)
+{
+    // One entry per shard, keys of the same shard differ by the shard count.
+    payload_cache cache(1);
+    const auto payload = make_payload(1);
+
+    BOOST_REQUIRE(!cache.duplicate(type, 0, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 16, payload));
+    BOOST_REQUIRE(!cache.duplicate(type, 0, payload));
+    BOOST_REQUIRE(cache.duplicate(type, 0, payload));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
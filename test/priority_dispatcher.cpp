@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+typedef priority_dispatcher::priority priority;
+
+BOOST_AUTO_TEST_SUITE(priority_dispatcher_tests)
+
+BOOST_AUTO_TEST_CASE(priority_dispatcher__post__control__runs_before_queued_bulk)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 0);
+
+    std::mutex mutex;
+    std::vector<size_t> order;
+    const auto record = [&mutex, &order](size_t value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(value);
+    };
+
+    // Occupy the only run so that the following jobs queue behind it.
+    std::promise<void> started;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    dispatch.post(priority::bulk, [&started, released]()
+    {
+        started.set_value();
+        released.wait();
+    });
+
+    started.get_future().wait();
+    dispatch.post(priority::bulk, [&record]() { record(1); });
+    dispatch.post(priority::bulk, [&record]() { record(2); });
+    dispatch.post(priority::control, [&record]() { record(0); });
+    BOOST_REQUIRE_EQUAL(dispatch.size(priority::bulk), 2u);
+    BOOST_REQUIRE_EQUAL(dispatch.size(priority::control), 1u);
+
+    std::promise<void> done;
+    dispatch.post(priority::bulk, [&done]() { done.set_value(); });
+    release.set_value();
+    done.get_future().wait();
+
+    const std::vector<size_t> expected{ 0, 1, 2 };
+    BOOST_REQUIRE(order == expected);
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(priority_dispatcher__strand_post__concurrent_pool__post_order_never_concurrent)
+{
+    static const size_t jobs = 64;
+    threadpool pool;
+    pool.spawn(4);
+    priority_dispatcher dispatch(pool, 4, 0);
+    const auto strand = std::make_shared<priority_dispatcher::strand>(
+        dispatch);
+
+    std::atomic<size_t> active(0);
+    std::atomic<bool> overlapped(false);
+    std::vector<size_t> order;
+    std::promise<void> done;
+
+    for (size_t job = 0; job < jobs; ++job)
+    {
+        // Alternate lanes, the strand orders across both.
+        const auto lane = job % 2 == 0 ? priority::bulk : priority::control;
+        strand->post(lane, [&, job]()
+        {
+            if (++active != 1)
+                overlapped = true;
+
+            order.push_back(job);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            --active;
+
+            if (job == jobs - 1)
+                done.set_value();
+        });
+
+        // Unrelated work competes for the same runs.
+        dispatch.post(priority::bulk, []() {});
+    }
+
+    done.get_future().wait();
+    BOOST_REQUIRE(!overlapped);
+    BOOST_REQUIRE_EQUAL(order.size(), jobs);
+
+    for (size_t job = 0; job < jobs; ++job)
+        BOOST_REQUIRE_EQUAL(order[job], job);
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(priority_dispatcher__resume__strand_backlog__deferred_until_taken)
+{
+    threadpool pool;
+    pool.spawn(1);
+    priority_dispatcher dispatch(pool, 1, 2);
+    const auto strand = std::make_shared<priority_dispatcher::strand>(
+        dispatch);
+
+    // Occupy the strand, its later jobs wait on the strand, not the lanes.
+    std::promise<void> started;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    strand->post(priority::bulk, [&started, released]()
+    {
+        started.set_value();
+        released.wait();
+    });
+
+    started.get_future().wait();
+    strand->post(priority::bulk, []() {});
+    strand->post(priority::bulk, []() {});
+    BOOST_REQUIRE_EQUAL(dispatch.size(priority::bulk), 0u);
+
+    std::promise<void> resumed;
+    auto resumed_future = resumed.get_future();
+    dispatch.resume([&resumed]() { resumed.set_value(); });
+    BOOST_REQUIRE(resumed_future.wait_for(std::chrono::milliseconds(50)) ==
+        std::future_status::timeout);
+
+    release.set_value();
+    resumed_future.wait();
+
+    std::promise<void> done;
+    strand->post(priority::bulk, [&done]() { done.set_value(); });
+    done.get_future().wait();
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+static const auto protocol_version = version::level::maximum;
+static const uint32_t protocol_magic = 0xd9b4bef9;
+
+BOOST_AUTO_TEST_SUITE(proxy_tests)
+
+BOOST_AUTO_TEST_CASE(proxy__serialize__ping__expected)
+{
+    const ping message(42);
+    const auto expected = message::serialize(protocol_version, message,
+        protocol_magic);
+    const auto buffer = proxy::serialize(message, protocol_version,
+        protocol_magic);
+    BOOST_REQUIRE(*buffer == expected);
+}
+
+BOOST_AUTO_TEST_CASE(proxy__serialize__recycled__same_buffer_and_storage)
+{
+    const ping message(42);
+    const void* buffer;
+    const void* storage;
+
+    // The first buffer warms the pool of this thread and is recycled.
+    {
+        const auto first = proxy::serialize(message, protocol_version,
+            protocol_magic);
+        buffer = first.get();
+        storage = first->data();
+    }
+
+    // Neither the buffer nor its storage is allocated again.
+    const auto second = proxy::serialize(message, protocol_version,
+        protocol_magic);
+    BOOST_REQUIRE(second.get() == buffer);
+    BOOST_REQUIRE(second->data() == storage);
+    BOOST_REQUIRE_EQUAL(second->size(), heading::satoshi_fixed_size() +
+        message.serialized_size(protocol_version));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
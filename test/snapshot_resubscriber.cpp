@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(snapshot_resubscriber_tests)
+
+typedef snapshot_resubscriber<code, size_t> test_subscriber;
+
+BOOST_AUTO_TEST_CASE(snapshot_resubscriber__invoke__resubscribed__invoked_again)
+{
+    threadpool pool;
+    const auto instance = std::make_shared<test_subscriber>(pool, "test");
+    instance->start();
+
+    size_t calls = 0;
+    instance->subscribe([&](const code&, size_t value)
+    {
+        calls += value;
+        return true;
+    }, error::service_stopped, 0);
+
+    instance->invoke(error::success, 1);
+    instance->invoke(error::success, 2);
+    BOOST_REQUIRE_EQUAL(calls, 3u);
+    instance->stop();
+    instance->invoke(error::service_stopped, 0);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_resubscriber__invoke__expired__not_invoked_again)
+{
+    threadpool pool;
+    const auto instance = std::make_shared<test_subscriber>(pool, "test");
+    instance->start();
+
+    size_t calls = 0;
+    instance->subscribe([&](const code&, size_t)
+    {
+        ++calls;
+        return false;
+    }, error::service_stopped, 0);
+
+    instance->invoke(error::success, 1);
+    instance->invoke(error::success, 1);
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+    instance->stop();
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_resubscriber__invoke__stopped__released)
+{
+    threadpool pool;
+    const auto instance = std::make_shared<test_subscriber>(pool, "test");
+    instance->start();
+
+    size_t calls = 0;
+    instance->subscribe([&](const code&, size_t)
+    {
+        ++calls;
+        return true;
+    }, error::service_stopped, 0);
+
+    instance->stop();
+    instance->invoke(error::service_stopped, 0);
+    instance->invoke(error::service_stopped, 0);
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_resubscriber__subscribe__stopped__stop_arguments)
+{
+    threadpool pool;
+    const auto instance = std::make_shared<test_subscriber>(pool, "test");
+
+    code result;
+    size_t value = 0;
+    instance->subscribe([&](const code& ec, size_t argument)
+    {
+        result = ec;
+        value = argument;
+        return true;
+    }, error::service_stopped, 42);
+
+    BOOST_REQUIRE_EQUAL(result, error::service_stopped);
+    BOOST_REQUIRE_EQUAL(value, 42u);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_resubscriber__invoke__concurrent__serialized_and_expired_once)
+{
+    threadpool pool;
+    const auto instance = std::make_shared<test_subscriber>(pool, "test");
+    instance->start();
+
+    std::atomic<size_t> running(0);
+    std::atomic<size_t> overlaps(0);
+    std::atomic<size_t> expirations(0);
+
+    instance->subscribe([&](const code&, size_t)
+    {
+        if (running.fetch_add(1) != 0)
+            ++overlaps;
+
+        running.fetch_sub(1);
+        return true;
+    }, error::service_stopped, 0);
+
+    instance->subscribe([&](const code&, size_t)
+    {
+        ++expirations;
+        return false;
+    }, error::service_stopped, 0);
+
+    std::vector<std::thread> invokers;
+
+    for (size_t thread = 0; thread < 4; ++thread)
+        invokers.emplace_back([&instance]()
+        {
+            for (size_t invoke = 0; invoke < 1000; ++invoke)
+                instance->invoke(error::success, 1);
+        });
+
+    for (auto& invoker: invokers)
+        invoker.join();
+
+    BOOST_REQUIRE_EQUAL(overlaps.load(), 0u);
+    BOOST_REQUIRE_EQUAL(expirations.load(), 1u);
+    instance->stop();
+    instance->invoke(error::service_stopped, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
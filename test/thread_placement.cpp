@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+typedef thread_placement::processors processors;
+
+BOOST_AUTO_TEST_SUITE(thread_placement_tests)
+
+BOOST_AUTO_TEST_CASE(thread_placement__parse__ranges__expected)
+{
+    const auto cpus = thread_placement::parse("8, 0-2,10-11,1");
+    BOOST_REQUIRE((cpus == processors{ 0, 1, 2, 8, 10, 11 }));
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__parse__invalid__empty)
+{
+    BOOST_REQUIRE(thread_placement::parse("3-1").empty());
+    BOOST_REQUIRE(thread_placement::parse("0,x").empty());
+    BOOST_REQUIRE(thread_placement::parse("").empty());
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__assignment__processor_set__all_threads)
+{
+    const thread_placement placement({ 3, 1 }, false);
+    BOOST_REQUIRE(!placement.empty());
+    BOOST_REQUIRE((placement.assignment(0) == processors{ 1, 3 }));
+    BOOST_REQUIRE((placement.assignment(5) == processors{ 1, 3 }));
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__apply__unconstrained__no_op)
+{
+    threadpool pool;
+    pool.spawn(2);
+    const thread_placement placement({}, false);
+    BOOST_REQUIRE(placement.empty());
+    BOOST_REQUIRE(placement.apply(pool, 2));
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__apply__idle_threads__true)
+{
+    threadpool pool;
+    pool.spawn(2);
+    const thread_placement placement({ 0 }, false);
+    BOOST_REQUIRE(placement.apply(pool, 2));
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__apply__fewer_threads__false)
+{
+    threadpool pool;
+    pool.spawn(1);
+    const thread_placement placement({ 0 }, false);
+    BOOST_REQUIRE(!placement.apply(pool, 2));
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__place__spawned_thread__placed)
+{
+    threadpool pool;
+    pool.spawn(1);
+    const thread_placement placement({ 0 }, false);
+    BOOST_REQUIRE(placement.apply(pool, 1));
+    pool.spawn(1);
+    placement.place(pool, 1);
+
+    // Hold both threads so that each pair of jobs runs on distinct threads,
+    // retrying until the place job has reached the new thread.
+    std::atomic<size_t> placed(0);
+    std::atomic<size_t> arrived(0);
+
+    for (size_t round = 1; round <= 100 && placed.load() < 2; ++round)
+    {
+        placed = 0;
+        const auto target = 2 * round;
+        const auto check = [&placed, &arrived, target]()
+        {
+            if (thread_placement::placed())
+                ++placed;
+
+            ++arrived;
+            while (arrived.load() < target)
+                std::this_thread::yield();
+        };
+
+        pool.service().post(check);
+        pool.service().post(check);
+
+        while (arrived.load() < target)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    pool.shutdown();
+    pool.join();
+    BOOST_REQUIRE_EQUAL(placed.load(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(thread_placement__parse__high_bit_characters__empty)
+{
+    BOOST_REQUIRE(thread_placement::parse("\xb9").empty());
+    BOOST_REQUIRE(thread_placement::parse("1-\xa0").empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+typedef priority_dispatcher::priority priority;
+
+static const auto resolution = asio::milliseconds(10);
+static const auto period = asio::milliseconds(20);
+
+// Poll until the predicate holds, for at most ten seconds.
+template <typename Predicate>
+static bool poll(Predicate predicate)
+{
+    for (size_t count = 0; count < 1000 && !predicate(); ++count)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return predicate();
+}
+
+BOOST_AUTO_TEST_SUITE(thread_scaler_tests)
+
+BOOST_AUTO_TEST_CASE(thread_scaler__start__fixed__minimum)
+{
+    threadpool pool;
+    pool.spawn(2);
+    timer_wheel wheel(pool, resolution, 1);
+    priority_dispatcher dispatch(pool, 2, 0);
+    const thread_placement placement({}, false);
+    thread_scaler scaler(pool, wheel, dispatch, placement, 0, 2, 2);
+    wheel.start();
+    scaler.start();
+    BOOST_REQUIRE_EQUAL(scaler.size(), 2u);
+    BOOST_REQUIRE_EQUAL(scaler.resizes(), 0u);
+
+    scaler.stop();
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(thread_scaler__sample__queue_backlog__grows)
+{
+    // The second thread keeps the wheel ticking while the first is blocked.
+    threadpool pool;
+    pool.spawn(2);
+    timer_wheel wheel(pool, resolution, 1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    const thread_placement placement({}, false);
+    thread_scaler scaler(pool, wheel, dispatch, placement, 0, 1, 2);
+    wheel.start();
+    scaler.start();
+
+    // Occupy the dispatcher with a blocked job and queue a backlog behind it.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    dispatch.post(priority::bulk, [released]() { released.wait(); });
+
+    for (size_t job = 0; job < 16; ++job)
+        dispatch.post(priority::bulk, []() {});
+
+    for (size_t poll = 0; poll < 100 && scaler.size() < 2; ++poll)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    BOOST_REQUIRE_EQUAL(scaler.size(), 2u);
+    BOOST_REQUIRE_EQUAL(scaler.resizes(), 1u);
+
+    release.set_value();
+    scaler.stop();
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(thread_scaler__sample__load_idle_load__grows_parks_wakes)
+{
+    threadpool pool;
+    pool.spawn(2);
+    timer_wheel wheel(pool, resolution, 1);
+    priority_dispatcher dispatch(pool, 1, 0);
+    const thread_placement placement({ 0 }, false);
+    BOOST_REQUIRE(placement.apply(pool, 2));
+    thread_scaler scaler(pool, wheel, dispatch, placement, 0, 1, 2,
+        period);
+    wheel.start();
+    scaler.start();
+
+    // Load spawns a third pool thread, which is then placed.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    dispatch.post(priority::bulk, [released]() { released.wait(); });
+
+    for (size_t job = 0; job < 16; ++job)
+        dispatch.post(priority::bulk, []() {});
+
+    BOOST_REQUIRE(poll([&]() { return scaler.size() == 2; }));
+    BOOST_REQUIRE_EQUAL(pool.size(), 3u);
+    release.set_value();
+
+    // Idle parks a thread.
+    BOOST_REQUIRE(poll([&]() { return scaler.size() == 1; }));
+    BOOST_REQUIRE_EQUAL(scaler.resizes(), 2u);
+
+    // Load again wakes the parked thread rather than spawning another.
+    std::promise<void> release_again;
+    auto released_again = release_again.get_future().share();
+    dispatch.post(priority::bulk, [released_again]()
+    {
+        released_again.wait();
+    });
+
+    for (size_t job = 0; job < 16; ++job)
+        dispatch.post(priority::bulk, []() {});
+
+    BOOST_REQUIRE(poll([&]() { return scaler.size() == 2; }));
+    BOOST_REQUIRE_EQUAL(scaler.resizes(), 3u);
+    BOOST_REQUIRE_EQUAL(pool.size(), 3u);
+
+    // Every pool thread, including the spawned one, has been placed.
+    release_again.set_value();
+    BOOST_REQUIRE(poll([&]() { return dispatch.size(priority::bulk) == 0; }));
+    scaler.stop();
+
+    std::atomic<size_t> placed(0);
+    std::atomic<size_t> arrived(0);
+    for (size_t thread = 0; thread < 3; ++thread)
+    {
+        pool.service().post([&]()
+        {
+            if (thread_placement::placed())
+                ++placed;
+
+            // Hold each thread so that every job runs on a distinct thread.
+            ++arrived;
+            poll([&]() { return arrived.load() == 3; });
+        });
+    }
+
+    BOOST_REQUIRE(poll([&]() { return arrived.load() == 3; }));
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+    BOOST_REQUIRE_EQUAL(placed.load(), 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
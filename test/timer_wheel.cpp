@@ -0,0 +1,245 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static const auto resolution = asio::milliseconds(1);
+
+// The furthest expiry of the wheel, six bits of ticks on each of four levels.
+static const uint64_t maximum_ticks = (uint64_t(1) << 24) - 1;
+
+BOOST_AUTO_TEST_SUITE(timer_wheel_tests)
+
+BOOST_AUTO_TEST_CASE(timer_wheel__start__expires__success)
+{
+    threadpool pool;
+    pool.spawn(1);
+    timer_wheel wheel(pool, resolution, 2);
+    wheel.start();
+
+    std::promise<code> promise;
+    timer_wheel::timer timer(wheel, asio::milliseconds(5));
+    timer.start([&promise](const code& ec)
+    {
+        promise.set_value(ec);
+    });
+
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), error::success);
+    BOOST_REQUIRE(wheel.now() >= 5);
+
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__stop__pending__not_invoked)
+{
+    threadpool pool;
+    pool.spawn(1);
+    timer_wheel wheel(pool, resolution, 1);
+    wheel.start();
+
+    std::atomic<bool> fired(false);
+    timer_wheel::timer stopped(wheel, asio::milliseconds(2));
+    stopped.start([&fired](const code&)
+    {
+        fired = true;
+    });
+
+    stopped.stop();
+
+    std::promise<code> promise;
+    timer_wheel::timer later(wheel, asio::milliseconds(10));
+    later.start([&promise](const code& ec)
+    {
+        promise.set_value(ec);
+    });
+
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), error::success);
+    BOOST_REQUIRE(!fired);
+
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__start__restart__replaces_handler)
+{
+    threadpool pool;
+    pool.spawn(1);
+    timer_wheel wheel(pool, resolution, 1);
+    wheel.start();
+
+    std::atomic<size_t> first(0);
+    std::promise<code> promise;
+    timer_wheel::timer timer(wheel, asio::seconds(1));
+    timer.start([&first](const code&)
+    {
+        ++first;
+    });
+
+    timer.start([&promise](const code& ec)
+    {
+        promise.set_value(ec);
+    }, asio::milliseconds(4));
+
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), error::success);
+    BOOST_REQUIRE_EQUAL(first.load(), 0u);
+
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__advance__all_levels__expire_on_tick)
+{
+    threadpool pool;
+    timer_wheel wheel(pool, resolution, 1);
+
+    // Slot and level boundaries, where each expiry cascades from level 1-3.
+    const std::vector<uint64_t> expiries
+    {
+        1, 63, 64, 65, 127, 4095, 4096, 4097, 70000, 262143, 262144, 262145,
+        300007
+    };
+
+    std::vector<uint64_t> expired(expiries.size(), 0);
+    std::vector<std::unique_ptr<timer_wheel::timer>> timers;
+
+    for (size_t index = 0; index < expiries.size(); ++index)
+    {
+        timers.emplace_back(new timer_wheel::timer(wheel,
+            resolution * expiries[index]));
+        timers.back()->start([&wheel, &expired, index](const code& ec)
+        {
+            BOOST_REQUIRE_EQUAL(ec, error::success);
+            BOOST_REQUIRE_EQUAL(expired[index], 0u);
+            expired[index] = wheel.now();
+        });
+    }
+
+    // Each timer is still pending on the tick before its expiry.
+    for (size_t index = 0; index < expiries.size(); ++index)
+    {
+        wheel.advance(expiries[index] - 1);
+        BOOST_REQUIRE_EQUAL(expired[index], 0u);
+    }
+
+    wheel.advance(expiries.back());
+    BOOST_REQUIRE(expired == expiries);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__advance__unaligned_start__expires_on_tick)
+{
+    threadpool pool;
+    timer_wheel wheel(pool, resolution, 1);
+    wheel.advance(4096 + 64 + 5);
+
+    // The expiry crosses level 1 and 2 slot boundaries from an unaligned tick.
+    uint64_t expired = 0;
+    timer_wheel::timer timer(wheel, resolution * 8000);
+    timer.start([&wheel, &expired](const code&)
+    {
+        expired = wheel.now();
+    });
+
+    wheel.advance(4096 + 64 + 5 + 7999);
+    BOOST_REQUIRE_EQUAL(expired, 0u);
+    wheel.advance(4096 + 64 + 5 + 8000);
+    BOOST_REQUIRE_EQUAL(expired, 4096u + 64u + 5u + 8000u);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__advance__beyond_maximum__clamped)
+{
+    threadpool pool;
+    timer_wheel wheel(pool, resolution, 1);
+    wheel.advance(5);
+
+    uint64_t expired = 0;
+    timer_wheel::timer timer(wheel, resolution * (maximum_ticks + 1000));
+    timer.start([&wheel, &expired](const code&)
+    {
+        expired = wheel.now();
+    });
+
+    wheel.advance(5 + maximum_ticks - 1);
+    BOOST_REQUIRE_EQUAL(expired, 0u);
+    wheel.advance(5 + maximum_ticks);
+    BOOST_REQUIRE_EQUAL(expired, 5u + maximum_ticks);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__start__skipped_ticks__caught_up_in_order)
+{
+    threadpool pool;
+    pool.spawn(1);
+    timer_wheel wheel(pool, resolution, 2);
+
+    std::mutex mutex;
+    std::vector<uint64_t> expired;
+    std::promise<void> done;
+    const std::vector<uint64_t> expiries{ 3, 10, 40, 70, 100 };
+    std::vector<std::unique_ptr<timer_wheel::timer>> timers;
+
+    // Occupy the only thread so that the ticker falls behind.
+    std::promise<void> blocked;
+    pool.service().post([&blocked]()
+    {
+        blocked.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    });
+
+    blocked.get_future().wait();
+    wheel.start();
+
+    for (const auto expiry: expiries)
+    {
+        timers.emplace_back(new timer_wheel::timer(wheel,
+            resolution * expiry));
+        timers.back()->start([&, expiry](const code&)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            BOOST_REQUIRE(wheel.now() >= expiry);
+            expired.push_back(expiry);
+
+            if (expired.size() == expiries.size())
+                done.set_value();
+        });
+    }
+
+    done.get_future().wait();
+    BOOST_REQUIRE(expired == expiries);
+
+    wheel.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace std::placeholders;
+
+BOOST_AUTO_TEST_SUITE(unique_function_tests)
+
+static size_t bound(std::shared_ptr<size_t> value, size_t add,
+    const std::string& text)
+{
+    return *value + add + text.size();
+}
+
+struct oversized
+{
+    size_t operator()(size_t value) const
+    {
+        return value + data[0];
+    }
+
+    size_t data[32];
+};
+
+BOOST_AUTO_TEST_CASE(unique_function__construct__default__empty)
+{
+    const unique_function<void()> instance;
+    BOOST_REQUIRE(!instance);
+    BOOST_REQUIRE(!instance.inlined());
+}
+
+BOOST_AUTO_TEST_CASE(unique_function__construct__bound_member__inlined)
+{
+    const unique_function<size_t(size_t)> instance(std::bind(&bound,
+        std::make_shared<size_t>(1), _1, std::string("text")));
+    BOOST_REQUIRE(instance.inlined());
+    BOOST_REQUIRE_EQUAL(instance(2), 7u);
+}
+
+BOOST_AUTO_TEST_CASE(unique_function__construct__oversized__allocated)
+{
+    const unique_function<size_t(size_t)> instance(oversized{ { 3 } });
+    BOOST_REQUIRE(instance);
+    BOOST_REQUIRE(!instance.inlined());
+    BOOST_REQUIRE_EQUAL(instance(2), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(unique_function__construct__move_only_capture__invoked)
+{
+    std::unique_ptr<size_t> value(new size_t(40));
+    const unique_function<size_t(size_t)> instance(
+        [value = std::move(value)](size_t add) { return *value + add; });
+    BOOST_REQUIRE_EQUAL(instance(2), 42u);
+}
+
+BOOST_AUTO_TEST_CASE(unique_function__move__inlined__source_empty)
+{
+    const auto value = std::make_shared<size_t>(42);
+    unique_function<size_t()> source([value]() { return *value; });
+    const auto target = std::move(source);
+    BOOST_REQUIRE(!source);
+    BOOST_REQUIRE_EQUAL(target(), 42u);
+    BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(unique_function__assign__null__callable_released)
+{
+    const auto value = std::make_shared<size_t>(42);
+    unique_function<size_t()> instance([value]() { return *value; });
+    BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+    instance = nullptr;
+    BOOST_REQUIRE(!instance);
+    BOOST_REQUIRE_EQUAL(value.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
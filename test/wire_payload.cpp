@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+BOOST_AUTO_TEST_SUITE(wire_payload_tests)
+
+BOOST_AUTO_TEST_CASE(wire_payload__find__allocated__retained)
+{
+    const auto payload = std::make_shared<const data_chunk>(
+        data_chunk{ 1, 2, 3 });
+    const auto wire = std::make_shared<wire_payload>(payload);
+    const transaction::const_ptr message =
+        wire_payload::allocate<transaction>(wire);
+
+    BOOST_REQUIRE(wire_payload::find(message) == wire);
+    BOOST_REQUIRE(&wire->payload() == payload.get());
+    BOOST_REQUIRE_EQUAL(wire->checksum(), bitcoin_checksum(*payload));
+}
+
+BOOST_AUTO_TEST_CASE(wire_payload__find__not_allocated__null)
+{
+    const auto message = std::make_shared<const transaction>();
+    BOOST_REQUIRE(!wire_payload::find(message));
+}
+
+BOOST_AUTO_TEST_CASE(wire_payload__portable__default__false)
+{
+    wire_payload wire(std::make_shared<const data_chunk>());
+    BOOST_REQUIRE(!wire.portable());
+    wire.set_portable(true);
+    BOOST_REQUIRE(wire.portable());
+}
+
+BOOST_AUTO_TEST_SUITE_END()